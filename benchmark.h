@@ -0,0 +1,641 @@
+/**
+ * Benchmark harness shared by parallel_maximum.cpp and prefix_sum_scan.cpp
+ *
+ * Runs every selected method over a grid of array sizes and thread
+ * counts, with warm-up iterations and repetitions, and reports the
+ * min, median and p99 time per method as CSV or JSON. Inputs are
+ * generated from a fixed seed so runs are reproducible between builds.
+ *
+ * Usage: ./program --bench [--sizes=N,...] [--threads=T,...]
+ *                  [--methods=name,...|all] [--reps=R] [--warmup=W]
+ *                  [--seed=S] [--format=csv|json] [--perf]
+ *
+ * --perf adds hardware counters (cycles, instructions, LLC misses, dTLB
+ * misses, branch misses) per method, see perf_counters.h.
+ * --trace=FILE dumps per-thread, per-phase spans of the timed runs as
+ * Chrome trace JSON when built with -DENABLE_TRACE, see trace.h.
+ *
+ * Scaling mode (--scaling=strong|weak) sweeps thread counts from 1 to
+ * the hardware maximum and sizes from L1-resident to --max-size, and
+ * reports speedup, parallel efficiency and achieved GB/s per method.
+ *
+ * --input=FILE replaces the generated input with a memory-mapped binary
+ * array (see mapped_array.h); --output=FILE maps the scan output too.
+ *
+ * --dist=NAME picks the distribution of the generated input (uniform,
+ * sorted, reverse, equal, zipf, adversarial; see random_input.h).
+ * --numa=off|touch|bind places the generated arrays (see numa_array.h).
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mapped_array.h"
+#include "numa_array.h"
+#include "perf_counters.h"
+#include "random_input.h"
+#include "trace.h"
+
+struct BenchmarkOptions {
+    std::vector<size_t> sizes = {1000000};
+    std::vector<int> threads = {omp_get_max_threads()};
+    std::vector<std::string> methods = {"all"};
+    int repetitions = 10;
+    int warmup = 2;
+    uint64_t seed = 42;
+    Distribution distribution = Distribution::Uniform;
+    NumaPolicy numa = NumaPolicy::Touch;  // Placement of the generated arrays
+    std::string format = "csv";
+    bool perf = false;  // Collect hardware counters per method
+    std::string trace_path;  // Chrome trace output (needs -DENABLE_TRACE)
+
+    // Scaling mode ("strong" or "weak"; empty = plain benchmark)
+    std::string scaling;
+    size_t min_size = 4096;        // 16 KB of ints: L1-resident
+    size_t max_size = 268435456;   // 1 GB of ints
+    size_t size_step = 16;
+    bool sizes_given = false;
+    bool threads_given = false;
+
+    // Memory-mapped input/output files (empty = generated input)
+    std::string input_path;
+    std::string output_path;
+    bool populate = false;    // MAP_POPULATE the mappings
+    bool huge_pages = false;  // MADV_HUGEPAGE the mappings
+};
+
+/**
+ * One benchmarkable method: run() performs a single execution on the
+ * current input and verify() checks the output of the last execution
+ */
+struct BenchmarkMethod {
+    std::string name;
+    std::function<void()> run;
+    std::function<bool()> verify;
+    double bytes_per_element = 4;  // Compulsory memory traffic, for GB/s
+};
+
+struct BenchmarkStats {
+    double min_ms = 0;
+    double median_ms = 0;
+    double p99_ms = 0;
+};
+
+struct BenchmarkResult {
+    std::string method;
+    size_t n;
+    int threads;
+    int repetitions;
+    BenchmarkStats stats;
+    bool verified;
+    PerfCounts perf;  // Per-run averages, summed over threads
+};
+
+/**
+ * Splits "a,b,c" into its comma-separated fields
+ */
+inline std::vector<std::string> split_list(const std::string& text) {
+    std::vector<std::string> fields;
+    std::stringstream ss(text);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
+        if (!field.empty()) fields.push_back(field);
+    }
+    return fields;
+}
+
+/**
+ * Parses a size with an optional K/M/G suffix (powers of 1000). Signs,
+ * leading spaces and sizes that do not fit in size_t are rejected.
+ */
+inline bool parse_size(const std::string& text, size_t& value) {
+    // stoull would skip spaces and wrap a leading '-' around
+    if (text.empty() || text[0] < '0' || text[0] > '9') return false;
+    size_t pos = 0;
+    unsigned long long base;
+    try {
+        base = std::stoull(text, &pos);
+    } catch (...) {
+        return false;
+    }
+    std::string suffix = text.substr(pos);
+    unsigned long long multiplier;
+    if (suffix.empty())         multiplier = 1;
+    else if (suffix == "K")     multiplier = 1000ULL;
+    else if (suffix == "M")     multiplier = 1000000ULL;
+    else if (suffix == "G")     multiplier = 1000000000ULL;
+    else return false;
+    if (base > SIZE_MAX / multiplier) return false;
+    value = base * multiplier;
+    return true;
+}
+
+inline void print_benchmark_usage(const char* program) {
+    std::cerr << "Usage: " << program << " --bench [options]\n"
+              << "  --sizes=N,...       Array sizes (K/M/G suffixes allowed), default 1M\n"
+              << "  --threads=T,...     OpenMP thread counts, default omp_get_max_threads()\n"
+              << "  --methods=name,...  Methods to run, or 'all' (default)\n"
+              << "  --reps=R            Timed repetitions per method, default 10\n"
+              << "  --warmup=W          Untimed warm-up runs per method, default 2\n"
+              << "  --seed=S            Seed for the input generator, default 42\n"
+              << "  --dist=NAME         Input distribution: uniform (default), sorted, reverse,\n"
+              << "                      equal, zipf, adversarial\n"
+              << "  --numa=off|touch|bind\n"
+              << "                      Page placement of the generated arrays, default touch\n"
+              << "  --format=csv|json   Output format, default csv\n"
+              << "  --perf              Report hardware counters per method (Linux perf_event_open)\n"
+              << "  --trace=FILE        Write per-phase Chrome trace JSON (build with -DENABLE_TRACE)\n"
+              << "  --scaling[=strong|weak]\n"
+              << "                      Sweep threads 1..max and sizes min..max; report speedup,\n"
+              << "                      efficiency and GB/s (weak: sizes are per thread)\n"
+              << "  --min-size=N        Smallest size of the scaling sweep, default 4096\n"
+              << "  --max-size=N        Largest size of the scaling sweep, default 268435456\n"
+              << "  --size-step=F       Size multiplier between sweep points, default 16\n"
+              << "  --input=FILE        Map a raw or headered binary array instead of generating one\n"
+              << "  --output=FILE       Map the scan output to a headered file (scans only)\n"
+              << "  --populate          Prefault the mappings (MAP_POPULATE)\n"
+              << "  --huge-pages        Request transparent huge pages for the mappings\n";
+}
+
+/**
+ * Parses the benchmark command line. Returns false and fills error on
+ * an unknown option or a malformed value.
+ */
+inline bool parse_benchmark_options(int argc, char** argv, BenchmarkOptions& opts, std::string& error) {
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+        try {
+            if (key == "--bench") {
+                continue;
+            } else if (key == "--help") {
+                error.clear();
+                return false;
+            } else if (key == "--sizes") {
+                opts.sizes_given = true;
+                opts.sizes.clear();
+                for (const std::string& field : split_list(value)) {
+                    size_t n;
+                    if (!parse_size(field, n) || n == 0) {
+                        error = "invalid size '" + field + "'";
+                        return false;
+                    }
+                    opts.sizes.push_back(n);
+                }
+            } else if (key == "--threads") {
+                opts.threads_given = true;
+                opts.threads.clear();
+                for (const std::string& field : split_list(value)) {
+                    int t = std::stoi(field);
+                    if (t <= 0) {
+                        error = "invalid thread count '" + field + "'";
+                        return false;
+                    }
+                    opts.threads.push_back(t);
+                }
+            } else if (key == "--methods") {
+                opts.methods = split_list(value);
+            } else if (key == "--reps") {
+                opts.repetitions = std::stoi(value);
+            } else if (key == "--warmup") {
+                opts.warmup = std::stoi(value);
+            } else if (key == "--seed") {
+                opts.seed = std::stoull(value);
+            } else if (key == "--dist") {
+                if (!parse_distribution(value, opts.distribution)) {
+                    error = "unknown distribution '" + value + "'";
+                    return false;
+                }
+            } else if (key == "--numa") {
+                if (!parse_numa_policy(value, opts.numa)) {
+                    error = "--numa must be off, touch or bind";
+                    return false;
+                }
+            } else if (key == "--format") {
+                opts.format = value;
+            } else if (key == "--perf") {
+                opts.perf = true;
+            } else if (key == "--trace") {
+#ifdef ENABLE_TRACE
+                opts.trace_path = value;
+#else
+                error = "--trace requires a build with -DENABLE_TRACE";
+                return false;
+#endif
+            } else if (key == "--scaling") {
+                opts.scaling = value.empty() ? "strong" : value;
+            } else if (key == "--min-size" || key == "--max-size") {
+                size_t n;
+                if (!parse_size(value, n) || n == 0) {
+                    error = "invalid size '" + value + "'";
+                    return false;
+                }
+                (key == "--min-size" ? opts.min_size : opts.max_size) = n;
+            } else if (key == "--size-step") {
+                opts.size_step = std::stoull(value);
+            } else if (key == "--input" || key == "--output") {
+                if (value.empty()) {
+                    error = key + " needs a file name";
+                    return false;
+                }
+                (key == "--input" ? opts.input_path : opts.output_path) = value;
+            } else if (key == "--populate") {
+                opts.populate = true;
+            } else if (key == "--huge-pages") {
+                opts.huge_pages = true;
+            } else {
+                error = "unknown option '" + arg + "'";
+                return false;
+            }
+        } catch (...) {
+            error = "invalid value for " + key;
+            return false;
+        }
+    }
+
+    if (opts.sizes.empty() || opts.threads.empty() || opts.methods.empty()) {
+        error = "sizes, threads and methods must not be empty";
+        return false;
+    }
+    if (opts.repetitions <= 0 || opts.warmup < 0) {
+        error = "--reps must be > 0 and --warmup >= 0";
+        return false;
+    }
+    if (opts.format != "csv" && opts.format != "json") {
+        error = "--format must be csv or json";
+        return false;
+    }
+    if (!opts.input_path.empty() && (opts.sizes_given || opts.scaling == "weak")) {
+        error = "--input fixes the size: it cannot be combined with --sizes or weak scaling";
+        return false;
+    }
+    if (!opts.scaling.empty()) {
+        if (opts.scaling != "strong" && opts.scaling != "weak") {
+            error = "--scaling must be strong or weak";
+            return false;
+        }
+        if (opts.size_step < 2 || opts.min_size > opts.max_size) {
+            error = "--size-step must be >= 2 and --min-size <= --max-size";
+            return false;
+        }
+        // Default sweeps: sizes min..max geometrically, threads 1,2,4,...,max
+        if (!opts.sizes_given) {
+            opts.sizes.clear();
+            for (size_t n = opts.min_size; n <= opts.max_size; n *= opts.size_step) {
+                opts.sizes.push_back(n);
+                if (n > opts.max_size / opts.size_step) break;
+            }
+        }
+        if (!opts.threads_given) {
+            int max_threads = omp_get_num_procs();
+            opts.threads.clear();
+            for (int t = 1; t < max_threads; t *= 2) opts.threads.push_back(t);
+            opts.threads.push_back(max_threads);
+        }
+    }
+    return true;
+}
+
+/**
+ * Mapping flags requested on the command line
+ */
+inline MapOptions benchmark_map_options(const BenchmarkOptions& opts) {
+    MapOptions options;
+    options.populate = opts.populate;
+    options.huge_pages = opts.huge_pages;
+    return options;
+}
+
+/**
+ * Min, median and p99 (nearest-rank) of the samples
+ */
+inline BenchmarkStats compute_stats(std::vector<double> samples) {
+    BenchmarkStats stats;
+    if (samples.empty()) return stats;
+
+    std::sort(samples.begin(), samples.end());
+    size_t k = samples.size();
+    stats.min_ms = samples[0];
+    stats.median_ms = (k % 2 == 1) ? samples[k / 2] : (samples[k / 2 - 1] + samples[k / 2]) / 2;
+    size_t rank = (size_t)std::ceil(0.99 * k);
+    stats.p99_ms = samples[std::max<size_t>(rank, 1) - 1];
+    return stats;
+}
+
+inline void print_benchmark_results(const std::vector<BenchmarkResult>& results,
+                                    const BenchmarkOptions& opts, std::ostream& out) {
+    if (opts.format == "json") {
+        out << "{\n";
+        out << "  \"seed\": " << opts.seed << ",\n";
+        out << "  \"warmup\": " << opts.warmup << ",\n";
+#ifdef __VERSION__
+        out << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+#endif
+        out << "  \"results\": [\n";
+        for (size_t r = 0; r < results.size(); r++) {
+            const BenchmarkResult& res = results[r];
+            out << "    {\"method\": \"" << res.method << "\", \"n\": " << res.n
+                << ", \"threads\": " << res.threads << ", \"reps\": " << res.repetitions
+                << ", \"min_ms\": " << res.stats.min_ms << ", \"median_ms\": " << res.stats.median_ms
+                << ", \"p99_ms\": " << res.stats.p99_ms
+                << ", \"verified\": " << (res.verified ? "true" : "false");
+            if (opts.perf) {
+                for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                    out << ", \"" << perf_event_name(e) << "\": ";
+                    if (res.perf.valid[e]) out << (uint64_t)res.perf.value[e];
+                    else out << "null";
+                }
+            }
+            out << "}"
+                << (r + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    } else {
+        out << "method,n,threads,reps,min_ms,median_ms,p99_ms,verified";
+        if (opts.perf) {
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) out << "," << perf_event_name(e);
+        }
+        out << "\n";
+        for (const BenchmarkResult& res : results) {
+            out << res.method << "," << res.n << "," << res.threads << "," << res.repetitions << ","
+                << res.stats.min_ms << "," << res.stats.median_ms << "," << res.stats.p99_ms << ","
+                << (res.verified ? "true" : "false");
+            if (opts.perf) {
+                for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                    out << ",";
+                    if (res.perf.valid[e]) out << (uint64_t)res.perf.value[e];
+                    else out << "n/a";
+                }
+            }
+            out << "\n";
+        }
+    }
+}
+
+/**
+ * Resolves --methods against the available methods. Returns false after
+ * printing the list of valid names if an unknown method was requested.
+ */
+inline bool select_methods(const BenchmarkOptions& opts, const std::vector<BenchmarkMethod>& methods,
+                           std::vector<const BenchmarkMethod*>& selected) {
+    bool run_all = std::find(opts.methods.begin(), opts.methods.end(), "all") != opts.methods.end();
+    for (const BenchmarkMethod& m : methods) {
+        if (run_all || std::find(opts.methods.begin(), opts.methods.end(), m.name) != opts.methods.end()) {
+            selected.push_back(&m);
+        }
+    }
+    for (const std::string& name : opts.methods) {
+        bool known = (name == "all");
+        for (const BenchmarkMethod& m : methods) known = known || (m.name == name);
+        if (!known) {
+            std::cerr << "Error: unknown method '" << name << "'. Available:";
+            for (const BenchmarkMethod& m : methods) std::cerr << " " << m.name;
+            std::cerr << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Warm-up runs followed by timed repetitions of one method with the
+ * current thread count. When counters is given, they count only the
+ * timed runs (not warm-up or verification) and perf receives the
+ * per-run average. Warm-up runs are not traced either. Returns whether every repetition verified.
+ */
+inline bool measure_method(const BenchmarkMethod& m, const BenchmarkOptions& opts, BenchmarkStats& stats,
+                           PerfCounters* counters = nullptr, PerfCounts* perf = nullptr) {
+    TRACE_PAUSE();
+    for (int w = 0; w < opts.warmup; w++) m.run();
+    TRACE_RESUME();
+
+    if (counters) counters->reset();
+
+    std::vector<double> samples;
+    bool verified = true;
+    for (int r = 0; r < opts.repetitions; r++) {
+        if (counters) counters->resume();
+        double start = omp_get_wtime();
+        m.run();
+        double end = omp_get_wtime();
+        if (counters) counters->pause();
+        samples.push_back((end - start) * 1000);
+        verified = verified && m.verify();
+    }
+
+    if (counters && perf) {
+        *perf = counters->read();
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) perf->value[e] /= opts.repetitions;
+    }
+
+    stats = compute_stats(samples);
+    return verified;
+}
+
+/**
+ * True if prepare() has to run again for every thread count: NumaArray
+ * places the pages with the static_chunk partition of the team that
+ * allocates them, so the layout only matches the methods when both use
+ * the same thread count
+ */
+inline bool placed_per_team(const BenchmarkOptions& opts) {
+    return opts.numa != NumaPolicy::Off;
+}
+
+/**
+ * One measurement of the scaling sweep; method indexes the selection
+ */
+struct ScalingRow {
+    size_t method;
+    size_t n;
+    int threads;
+    BenchmarkStats stats;
+    bool verified;
+    PerfCounts perf;
+};
+
+/**
+ * Scaling sweep. Strong scaling keeps n fixed and reports
+ * speedup = T(1)/T(p); weak scaling uses n = size * p and reports the
+ * scaled speedup p * T(1)/T(p). Efficiency is speedup / p in both
+ * cases, and GB/s uses the method's compulsory traffic per element.
+ * --perf appends the hardware counters, as in the plain benchmark.
+ */
+inline int run_scaling(const BenchmarkOptions& opts, const std::vector<const BenchmarkMethod*>& selected,
+                       const std::function<void(size_t, uint64_t)>& prepare, std::ostream& out) {
+    bool weak = (opts.scaling == "weak");
+    bool json = (opts.format == "json");
+    bool all_verified = true;
+    bool first = true;
+    size_t prepared_n = 0;
+    int prepared_threads = 0;
+
+    if (json) {
+        out << "{\n  \"mode\": \"" << opts.scaling << "\",\n  \"seed\": " << opts.seed
+            << ",\n  \"max_threads\": " << omp_get_num_procs() << ",\n  \"results\": [\n";
+    } else {
+        out << "mode,method,n,threads,median_ms,speedup,efficiency,gb_per_s,verified";
+        if (opts.perf) {
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) out << "," << perf_event_name(e);
+        }
+        out << "\n";
+    }
+
+    for (size_t size : opts.sizes) {
+        // Threads outermost so each n is prepared once (weak scaling has a
+        // different n per thread count); rows are printed per method
+        std::vector<ScalingRow> rows;
+        for (int t : opts.threads) {
+            size_t n = weak ? size * t : size;
+            omp_set_num_threads(t);
+            if (n != prepared_n || (placed_per_team(opts) && t != prepared_threads)) {
+                prepare(n, opts.seed);
+                prepared_n = n;
+                prepared_threads = t;
+            }
+
+            // Counters are opened on the team that will run the methods
+            PerfCounters counters;
+            if (opts.perf && !counters.open(t)) {
+                std::cerr << "Warning: hardware counters unavailable "
+                          << "(no PMU, or kernel.perf_event_paranoid too strict)" << std::endl;
+            }
+
+            for (size_t i = 0; i < selected.size(); i++) {
+                ScalingRow row{i, n, t, BenchmarkStats(), false, PerfCounts()};
+                row.verified = opts.perf ? measure_method(*selected[i], opts, row.stats, &counters, &row.perf)
+                                         : measure_method(*selected[i], opts, row.stats);
+                all_verified = all_verified && row.verified;
+                rows.push_back(row);
+            }
+        }
+        std::stable_sort(rows.begin(), rows.end(),
+                         [](const ScalingRow& a, const ScalingRow& b) { return a.method < b.method; });
+
+        std::vector<double> baseline_ms(selected.size(), 0);
+        for (const ScalingRow& row : rows) {
+            const BenchmarkMethod* m = selected[row.method];
+            size_t n = row.n;
+            int t = row.threads;
+            const BenchmarkStats& stats = row.stats;
+            bool verified = row.verified;
+
+            // The first thread count of the sweep is the baseline
+            // (normally 1 thread; otherwise assumed to scale linearly)
+            double& baseline = baseline_ms[row.method];
+            if (baseline == 0) baseline = stats.median_ms;
+            double speedup = weak ? t * baseline / stats.median_ms
+                                  : opts.threads[0] * baseline / stats.median_ms;
+            double efficiency = speedup / t;
+            double gb_per_s = (n * m->bytes_per_element) / (stats.median_ms * 1e6);
+
+            if (json) {
+                out << (first ? "" : ",\n")
+                    << "    {\"method\": \"" << m->name << "\", \"n\": " << n << ", \"threads\": " << t
+                    << ", \"median_ms\": " << stats.median_ms << ", \"speedup\": " << speedup
+                    << ", \"efficiency\": " << efficiency << ", \"gb_per_s\": " << gb_per_s
+                    << ", \"verified\": " << (verified ? "true" : "false");
+                if (opts.perf) {
+                    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                        out << ", \"" << perf_event_name(e) << "\": ";
+                        if (row.perf.valid[e]) out << (uint64_t)row.perf.value[e];
+                        else out << "null";
+                    }
+                }
+                out << "}";
+            } else {
+                out << opts.scaling << "," << m->name << "," << n << "," << t << "," << stats.median_ms << ","
+                    << speedup << "," << efficiency << "," << gb_per_s << "," << (verified ? "true" : "false");
+                if (opts.perf) {
+                    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                        out << ",";
+                        if (row.perf.valid[e]) out << (uint64_t)row.perf.value[e];
+                        else out << "n/a";
+                    }
+                }
+                out << std::endl;
+            }
+            first = false;
+        }
+    }
+
+    if (json) out << "\n  ]\n}\n";
+    return all_verified ? 0 : 2;
+}
+
+/**
+ * Plain benchmark: every selected method for every (size, threads) pair
+ */
+inline int run_grid(const BenchmarkOptions& opts, const std::vector<const BenchmarkMethod*>& selected,
+                    const std::function<void(size_t, uint64_t)>& prepare, std::ostream& out) {
+    std::vector<BenchmarkResult> results;
+    bool all_verified = true;
+
+    for (size_t n : opts.sizes) {
+        for (int t : opts.threads) {
+            omp_set_num_threads(t);
+            if (t == opts.threads[0] || placed_per_team(opts)) prepare(n, opts.seed);
+
+            // Counters are opened on the team that will run the methods
+            PerfCounters counters;
+            if (opts.perf && !counters.open(t)) {
+                std::cerr << "Warning: hardware counters unavailable "
+                          << "(no PMU, or kernel.perf_event_paranoid too strict)" << std::endl;
+            }
+
+            for (const BenchmarkMethod* m : selected) {
+                BenchmarkStats stats;
+                PerfCounts perf;
+                bool verified = opts.perf ? measure_method(*m, opts, stats, &counters, &perf)
+                                          : measure_method(*m, opts, stats);
+                all_verified = all_verified && verified;
+                results.push_back({m->name, n, t, opts.repetitions, stats, verified, perf});
+            }
+        }
+    }
+
+    print_benchmark_results(results, opts, out);
+    return all_verified ? 0 : 2;
+}
+
+/**
+ * Runs the selected methods over every (size, threads) combination,
+ * or the scaling sweep when --scaling was given.
+ * prepare(n, seed) must regenerate the input and the reference result
+ * for size n; it runs after omp_set_num_threads() for the measured
+ * thread count, once per size, or once per (size, threads) when the
+ * arrays are NUMA-placed (--numa other than off). The data only depends
+ * on n and the seed, so every method and thread count sees the same
+ * input. Returns the process exit code.
+ */
+inline int run_benchmark(const BenchmarkOptions& opts, const std::vector<BenchmarkMethod>& methods,
+                         const std::function<void(size_t, uint64_t)>& prepare, std::ostream& out) {
+    std::vector<const BenchmarkMethod*> selected;
+    if (!select_methods(opts, methods, selected)) return 1;
+
+    int status = opts.scaling.empty() ? run_grid(opts, selected, prepare, out)
+                                      : run_scaling(opts, selected, prepare, out);
+
+#ifdef ENABLE_TRACE
+    if (!opts.trace_path.empty() && !trace_write_chrome_json(opts.trace_path)) {
+        std::cerr << "Error: cannot write trace to " << opts.trace_path << std::endl;
+        return 1;
+    }
+#endif
+    return status;
+}
+
+#endif // BENCHMARK_H
@@ -0,0 +1,44 @@
+/**
+ * Runtime CPU feature detection for the SIMD kernels
+ *
+ * SIMD_X86 is 1 when the compiler can build x86 vector kernels with
+ * __attribute__((target(...))); the kernels are only called when
+ * detect_simd_level() reports that the running CPU supports them, so
+ * one binary runs on any x86-64 machine.
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+enum class SimdLevel { Scalar, SSE41, AVX2, AVX512 };
+
+inline const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "AVX-512";
+        case SimdLevel::AVX2:   return "AVX2";
+        case SimdLevel::SSE41:  return "SSE4.1";
+        default:                return "Scalar";
+    }
+}
+
+/**
+ * Widest vector ISA supported by the running CPU (checked via CPUID)
+ */
+inline SimdLevel detect_simd_level() {
+#if SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2"))    return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))  return SimdLevel::SSE41;
+#endif
+    return SimdLevel::Scalar;
+}
+
+#endif // CPU_FEATURES_H
@@ -0,0 +1,201 @@
+/**
+ * Memory-mapped binary arrays for out-of-core inputs and outputs
+ *
+ * A file is mapped once and the methods run directly on the mapping
+ * (no copy into a vector), so files larger than RAM stream through the
+ * page cache. Two layouts are accepted:
+ *   - raw:      the elements only, native byte order
+ *               (e.g. numpy: arr.astype('<i4').tofile("data.bin"))
+ *   - headered: a 16-byte ArrayFileHeader followed by the elements
+ *
+ * The mapping is advised MADV_SEQUENTIAL so the kernel reads ahead
+ * aggressively and drops pages behind the scan. Optional flags:
+ *   - populate:   MAP_POPULATE, fault the whole file in at map time
+ *                 (only sensible when it fits in RAM)
+ *   - huge_pages: MADV_HUGEPAGE, ask for transparent huge pages to cut
+ *                 dTLB misses (best effort; file-backed THP depends on
+ *                 the kernel and filesystem)
+ */
+
+#ifndef MAPPED_ARRAY_H
+#define MAPPED_ARRAY_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_ARRAY_POSIX 1
+#else
+#define MAPPED_ARRAY_POSIX 0
+#endif
+
+struct MapOptions {
+    bool populate = false;
+    bool huge_pages = false;
+};
+
+struct ArrayFileHeader {
+    char magic[4];          // "PARR"
+    uint32_t element_size;  // sizeof(T) of the stored elements
+    uint64_t count;         // Number of elements after the header
+};
+static_assert(sizeof(ArrayFileHeader) == 16, "header layout must stay 16 bytes");
+
+inline const char ARRAY_FILE_MAGIC[4] = {'P', 'A', 'R', 'R'};
+
+template <typename T>
+class MappedArray {
+public:
+    MappedArray() = default;
+    MappedArray(const MappedArray&) = delete;
+    MappedArray& operator=(const MappedArray&) = delete;
+    ~MappedArray() { close(); }
+
+    /**
+     * Maps an existing raw or headered file read-only. Returns false and
+     * fills error if the file cannot be mapped or its size does not
+     * match the element type.
+     */
+    bool open(const std::string& path, const MapOptions& options, std::string& error) {
+        close();
+#if MAPPED_ARRAY_POSIX
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            error = "cannot open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            error = "cannot stat " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        size_t length = st.st_size;
+
+        // Headered if it starts with the magic, raw otherwise
+        size_t offset = 0;
+        size_t count = length / sizeof(T);
+        ArrayFileHeader header;
+        if (length >= sizeof(header) && pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+            std::memcmp(header.magic, ARRAY_FILE_MAGIC, 4) == 0) {
+            if (header.element_size != sizeof(T) || header.count > (length - sizeof(header)) / sizeof(T)) {
+                error = path + ": header does not match the element type or the file size";
+                ::close(fd);
+                return false;
+            }
+            offset = sizeof(header);
+            count = header.count;
+        } else if (length % sizeof(T) != 0) {
+            error = path + ": raw file size is not a multiple of " + std::to_string(sizeof(T)) + " bytes";
+            ::close(fd);
+            return false;
+        }
+        if (count == 0) {
+            error = path + ": no elements";
+            ::close(fd);
+            return false;
+        }
+
+        bool mapped = map_fd(fd, length, PROT_READ, options, error);
+        ::close(fd);  // The mapping keeps the file referenced
+        if (!mapped) return false;
+        data_ = reinterpret_cast<T*>(static_cast<char*>(base_) + offset);
+        count_ = count;
+        return true;
+#else
+        (void)path;
+        (void)options;
+        error = "memory-mapped files need a POSIX system";
+        return false;
+#endif
+    }
+
+    /**
+     * Creates (or truncates) a headered file of count elements and maps
+     * it read-write, e.g. as the output of an out-of-core scan
+     */
+    bool create(const std::string& path, size_t count, const MapOptions& options, std::string& error) {
+        close();
+#if MAPPED_ARRAY_POSIX
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            error = "cannot create " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        size_t length = sizeof(ArrayFileHeader) + count * sizeof(T);
+        if (ftruncate(fd, length) != 0) {
+            error = "cannot resize " + path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        bool mapped = map_fd(fd, length, PROT_READ | PROT_WRITE, options, error);
+        ::close(fd);
+        if (!mapped) return false;
+
+        ArrayFileHeader header;
+        std::memcpy(header.magic, ARRAY_FILE_MAGIC, 4);
+        header.element_size = sizeof(T);
+        header.count = count;
+        std::memcpy(base_, &header, sizeof(header));
+        data_ = reinterpret_cast<T*>(static_cast<char*>(base_) + sizeof(header));
+        count_ = count;
+        return true;
+#else
+        (void)path;
+        (void)count;
+        (void)options;
+        error = "memory-mapped files need a POSIX system";
+        return false;
+#endif
+    }
+
+    void close() {
+#if MAPPED_ARRAY_POSIX
+        if (base_) munmap(base_, length_);
+#endif
+        base_ = nullptr;
+        length_ = 0;
+        data_ = nullptr;
+        count_ = 0;
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return count_; }
+
+private:
+    void* base_ = nullptr;
+    size_t length_ = 0;
+    T* data_ = nullptr;
+    size_t count_ = 0;
+
+#if MAPPED_ARRAY_POSIX
+    bool map_fd(int fd, size_t length, int protection, const MapOptions& options, std::string& error) {
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        if (options.populate) flags |= MAP_POPULATE;
+#endif
+        void* base = mmap(nullptr, length, protection, flags, fd, 0);
+        if (base == MAP_FAILED) {
+            error = std::string("mmap failed: ") + std::strerror(errno);
+            return false;
+        }
+        madvise(base, length, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+        if (options.huge_pages) madvise(base, length, MADV_HUGEPAGE);
+#endif
+        base_ = base;
+        length_ = length;
+        return true;
+    }
+#endif
+};
+
+#endif // MAPPED_ARRAY_H
@@ -0,0 +1,107 @@
+/**
+ * Associative operators (monoids) for the generic reduction and scan
+ * engines in parallel_maximum.cpp and prefix_sum_scan.cpp
+ *
+ * A monoid provides identity() and an associative operator()(a, b),
+ * where a comes before b in the input. Commutativity is never assumed,
+ * so order-sensitive operators such as AffineOp are allowed.
+ */
+
+#ifndef MONOIDS_H
+#define MONOIDS_H
+
+#include <cstddef>
+#include <limits>
+
+template <typename T>
+struct MaxOp {
+    T identity() const { return std::numeric_limits<T>::lowest(); }
+    T operator()(T a, T b) const { return a < b ? b : a; }
+};
+
+template <typename T>
+struct MinOp {
+    T identity() const { return std::numeric_limits<T>::max(); }
+    T operator()(T a, T b) const { return b < a ? b : a; }
+};
+
+template <typename T>
+struct SumOp {
+    T identity() const { return T(0); }
+    T operator()(T a, T b) const { return a + b; }
+};
+
+template <typename T>
+struct ProductOp {
+    T identity() const { return T(1); }
+    T operator()(T a, T b) const { return a * b; }
+};
+
+template <typename T>
+struct BitAndOp {
+    T identity() const { return T(~T(0)); }
+    T operator()(T a, T b) const { return a & b; }
+};
+
+template <typename T>
+struct BitOrOp {
+    T identity() const { return T(0); }
+    T operator()(T a, T b) const { return a | b; }
+};
+
+template <typename T>
+struct BitXorOp {
+    T identity() const { return T(0); }
+    T operator()(T a, T b) const { return a ^ b; }
+};
+
+/**
+ * Affine map x -> a*x + b. A scan of these maps with AffineOp solves the
+ * first-order linear recurrence x[i] = a[i]*x[i-1] + b[i]: the inclusive
+ * prefix F[i] gives x[i] = F[i].a * x[-1] + F[i].b.
+ */
+template <typename T>
+struct Affine {
+    T a;
+    T b;
+};
+
+template <typename T>
+struct AffineOp {
+    Affine<T> identity() const { return {T(1), T(0)}; }
+    // Apply f first, then g: g(f(x)) = g.a*(f.a*x + f.b) + g.b
+    Affine<T> operator()(Affine<T> f, Affine<T> g) const { return {g.a * f.a, g.a * f.b + g.b}; }
+};
+
+/**
+ * A value with its position, for argmax/argmin. Ties keep the lower
+ * index, so the result does not depend on how the input was split.
+ */
+template <typename T>
+struct ValueIndex {
+    T value;
+    size_t index;
+};
+
+template <typename T>
+inline bool operator==(const ValueIndex<T>& a, const ValueIndex<T>& b) {
+    return a.value == b.value && a.index == b.index;
+}
+
+template <typename T>
+struct ArgMaxOp {
+    ValueIndex<T> identity() const { return {std::numeric_limits<T>::lowest(), std::numeric_limits<size_t>::max()}; }
+    ValueIndex<T> operator()(ValueIndex<T> a, ValueIndex<T> b) const {
+        return (a.value < b.value || (!(b.value < a.value) && b.index < a.index)) ? b : a;
+    }
+};
+
+template <typename T>
+struct ArgMinOp {
+    ValueIndex<T> identity() const { return {std::numeric_limits<T>::max(), std::numeric_limits<size_t>::max()}; }
+    ValueIndex<T> operator()(ValueIndex<T> a, ValueIndex<T> b) const {
+        return (b.value < a.value || (!(a.value < b.value) && b.index < a.index)) ? b : a;
+    }
+};
+
+#endif // MONOIDS_H
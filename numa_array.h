@@ -0,0 +1,222 @@
+/**
+ * NUMA-aware arrays and the static partition shared by the methods
+ *
+ * `vector<int> arr(n)` zeroes every page on the allocating thread, so on a
+ * multi-socket machine the whole array lands on that thread's node and
+ * the other sockets read it across the interconnect. NumaArray maps the
+ * memory untouched and places every page with the thread that owns it
+ * under static_chunk(), the partition of parallel_max_sections,
+ * parallel_prefix_sum_recursive and fill_input():
+ *   - touch: each thread faults in the pages of its own chunk
+ *            (first-touch policy of the kernel)
+ *   - bind:  each thread also mbind()s its chunk to the node it runs on,
+ *            so the placement holds even if another thread writes first
+ *            (falls back to touch where mbind is unavailable)
+ *   - off:   plain untouched memory, placed by whoever writes it first
+ *
+ * Placement only pays off if the OpenMP threads stay on their cores, e.g.
+ * OMP_PROC_BIND=close OMP_PLACES=cores, and the same thread count is used
+ * for the allocation and for the methods (the benchmark re-places its
+ * arrays for every thread count it measures).
+ */
+
+#ifndef NUMA_ARRAY_H
+#define NUMA_ARRAY_H
+
+#include <omp.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define NUMA_ARRAY_POSIX 1
+#else
+#define NUMA_ARRAY_POSIX 0
+#endif
+
+#if defined(__linux__) && __has_include(<linux/mempolicy.h>)
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#define NUMA_ARRAY_MBIND 1
+#else
+#define NUMA_ARRAY_MBIND 0
+#endif
+
+enum class NumaPolicy { Off, Touch, Bind };
+
+inline const char* numa_policy_name(NumaPolicy policy) {
+    switch (policy) {
+        case NumaPolicy::Off:   return "off";
+        case NumaPolicy::Touch: return "touch";
+        case NumaPolicy::Bind:  return "bind";
+    }
+    return "unknown";
+}
+
+inline bool parse_numa_policy(const std::string& name, NumaPolicy& policy) {
+    for (NumaPolicy p : {NumaPolicy::Off, NumaPolicy::Touch, NumaPolicy::Bind}) {
+        if (name == numa_policy_name(p)) {
+            policy = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Thread tid's contiguous chunk [start, end) of n elements split over
+ * num_threads threads (ceil-sized chunks, the last ones may be empty)
+ *
+ * The methods size their per-thread arrays with omp_get_max_threads()
+ * and open the region with num_threads() of that count, assuming the
+ * runtime delivers the full team: OMP_DYNAMIC off (the default) and not
+ * called from inside another parallel region. With a smaller team the
+ * chunks of the missing threads would not be processed.
+ */
+inline void static_chunk(size_t n, int tid, int num_threads, size_t& start, size_t& end) {
+    size_t chunk_size = (n + num_threads - 1) / num_threads;
+    start = std::min(tid * chunk_size, n);
+    end = std::min(start + chunk_size, n);
+}
+
+/**
+ * Number of NUMA nodes with memory, 1 where the topology is unknown
+ */
+inline int numa_node_count() {
+    static const int count = [] {
+        // "0" or "0-1" or "0,2-3": the highest listed node plus one
+        std::ifstream online("/sys/devices/system/node/online");
+        std::string list;
+        if (!(online >> list)) return 1;
+        size_t last = list.find_last_of(",-");
+        int highest = std::atoi(list.c_str() + (last == std::string::npos ? 0 : last + 1));
+        return std::max(highest + 1, 1);
+    }();
+    return count;
+}
+
+/**
+ * Node of the CPU the calling thread is running on (0 if unknown)
+ */
+inline int current_numa_node() {
+#if NUMA_ARRAY_MBIND && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return (int)node;
+#endif
+    return 0;
+}
+
+template <typename T>
+class NumaArray {
+public:
+    NumaArray() = default;
+    NumaArray(const NumaArray&) = delete;
+    NumaArray& operator=(const NumaArray&) = delete;
+    ~NumaArray() { release(); }
+
+    /**
+     * Replaces the contents with n elements placed by policy. The
+     * elements are zero (anonymous memory). Throws bad_alloc on failure.
+     */
+    void allocate(size_t n, NumaPolicy policy) {
+        release();
+        if (n == 0) return;
+        length_ = n * sizeof(T);
+#if NUMA_ARRAY_POSIX
+        void* base = mmap(nullptr, length_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            length_ = 0;
+            throw std::bad_alloc();
+        }
+#else
+        void* base = std::calloc(n, sizeof(T));
+        if (!base) throw std::bad_alloc();
+#endif
+        data_ = static_cast<T*>(base);
+        count_ = n;
+        bound_ = false;
+        if (policy != NumaPolicy::Off) place(policy == NumaPolicy::Bind);
+    }
+
+    void release() {
+        if (data_) {
+#if NUMA_ARRAY_POSIX
+            munmap(data_, length_);
+#else
+            std::free(data_);
+#endif
+        }
+        data_ = nullptr;
+        count_ = 0;
+        length_ = 0;
+        bound_ = false;
+    }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+    size_t size() const { return count_; }
+    T* begin() { return data_; }
+    T* end() { return data_ + count_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + count_; }
+    T& operator[](size_t i) { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+    /** True if every chunk was mbind()-ed to its thread's node */
+    bool bound() const { return bound_; }
+
+private:
+    T* data_ = nullptr;
+    size_t count_ = 0;
+    size_t length_ = 0;
+    bool bound_ = false;
+
+    /**
+     * Each thread binds (optionally) and faults in the pages that start
+     * inside its chunk, so a page shared by two chunks goes to the
+     * thread that owns its first element
+     */
+    void place(bool bind) {
+#if NUMA_ARRAY_POSIX
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        char* bytes = reinterpret_cast<char*>(data_);
+        std::atomic<bool> all_bound(bind && NUMA_ARRAY_MBIND);
+
+        #pragma omp parallel
+        {
+            size_t start, end;
+            static_chunk(count_, omp_get_thread_num(), omp_get_num_threads(), start, end);
+            size_t first = (start * sizeof(T) + page - 1) / page * page;
+            size_t last = std::min((end * sizeof(T) + page - 1) / page * page, length_);
+
+            if (first < last) {
+#if NUMA_ARRAY_MBIND
+                if (bind) {
+                    unsigned long mask[16] = {};  // Up to 1024 nodes
+                    int node = current_numa_node();
+                    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+                    // maxnode counts one past the last bit, as in libnuma
+                    if (syscall(SYS_mbind, bytes + first, last - first, MPOL_BIND, mask, 8 * sizeof(mask) + 1, 0) != 0) {
+                        all_bound = false;
+                    }
+                }
+#endif
+                for (size_t offset = first; offset < last; offset += page) {
+                    bytes[offset] = 0;
+                }
+            }
+        }
+        bound_ = all_bound;
+#else
+        (void)bind;
+#endif
+    }
+};
+
+#endif // NUMA_ARRAY_H
@@ -4,7 +4,7 @@
  * This implementation finds the maximum value in an array using
  * parallel reduction with OpenMP.
  * 
- * Compilation: g++ -fopenmp parallel_maximum.cpp -o parallel_maximum
+ * Compilation: g++ -O3 -fopenmp parallel_maximum.cpp -o parallel_maximum
  * Execution: ./parallel_maximum
  */
 
@@ -14,10 +14,30 @@
 #include <algorithm>
 #include <climits>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <ctime>
+#include <limits>
+#include <type_traits>
+#include <tuple>
+#include <filesystem>
+#include <fstream>
+
+#include "benchmark.h"
+#include "cpu_features.h"
+#include "mapped_array.h"
+#include "monoids.h"
+#include "numa_array.h"
+#include "random_input.h"
+#include "segments.h"
+#include "trace.h"
+#include "uring_reader.h"
 
 using namespace std;
 
+// Debug printing of intermediate tree states (disabled in benchmark mode)
+bool debug_output = true;
+
 /**
  * Method 1: Parallel Maximum using OpenMP reduction clause
  * This is the simplest and most efficient approach
@@ -25,11 +45,11 @@ using namespace std;
  * Time Complexity: O(N) work, O(log N) span
  * Synchronization: log2(N) implicit barriers
  */
-int parallel_max_reduction(const vector<int>& arr, int n) {
+int parallel_max_reduction(const int* arr, size_t n) {
     int max_val = INT_MIN;
     
     #pragma omp parallel for reduction(max:max_val)
-    for (int i = 0; i < n; i++) {
+    for (size_t i = 0; i < n; i++) {
         if (arr[i] > max_val) {
             max_val = arr[i];
         }
@@ -43,24 +63,33 @@ int parallel_max_reduction(const vector<int>& arr, int n) {
  * This implementation shows the explicit tree-based reduction
  * similar to the abstract pseudocode
  * 
+ * A single parallel region is opened per call; the team stays alive
+ * across levels and synchronizes with in-team barriers, so fork/join
+ * is paid once instead of log2(N) times.
+ * 
  * Time Complexity: O(N) work, O(log N) span
  * Synchronization: log2(N) explicit barriers
  */
-int parallel_max_tree_reduction(vector<int>& arr, int n) {
-    vector<int> temp(arr);  // Working array
-    
-    int stride = 1;
+int parallel_max_tree_reduction(const int* arr, size_t n) {
+    vector<int> temp(arr, arr + n);  // Working array
     
-    // Tree reduction phase
-    while (stride < n) {
-        #pragma omp parallel for
-        for (int i = 0; i < n; i += 2 * stride) {
-            if (i + stride < n) {
-                temp[i] = max(temp[i], temp[i + stride]);
+    #pragma omp parallel
+    {
+        // Tree reduction phase (every thread walks the same levels)
+        size_t stride = 1;
+        for (int level = 0; stride < n; level++, stride *= 2) {
+            {
+                TRACE_SCOPE_ARG("tree-level", level);
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i += 2 * stride) {
+                    if (i + stride < n) {
+                        temp[i] = max(temp[i], temp[i + stride]);
+                    }
+                }
             }
+            // In-team barrier between levels
+            #pragma omp barrier
         }
-        // Implicit barrier at end of parallel for
-        stride *= 2;
     }
     
     return temp[0];
@@ -72,19 +101,20 @@ int parallel_max_tree_reduction(vector<int>& arr, int n) {
  * 
  * Time Complexity: O(N) work, O(log N) span with P processors
  */
-int parallel_max_sections(const vector<int>& arr, int n) {
+int parallel_max_sections(const int* arr, size_t n) {
     int num_threads = omp_get_max_threads();
     vector<int> partial_max(num_threads, INT_MIN);
     
     #pragma omp parallel
     {
         int tid = omp_get_thread_num();
-        int chunk_size = (n + num_threads - 1) / num_threads;
-        int start = tid * chunk_size;
-        int end = min(start + chunk_size, n);
+        size_t chunk_size = (n + num_threads - 1) / num_threads;
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
         
         // Each thread finds max in its chunk
-        for (int i = start; i < end; i++) {
+        TRACE_SCOPE("chunk-max");
+        for (size_t i = start; i < end; i++) {
             if (arr[i] > partial_max[tid]) {
                 partial_max[tid] = arr[i];
             }
@@ -103,50 +133,1088 @@ int parallel_max_sections(const vector<int>& arr, int n) {
 /**
  * Method 4: Parallel Maximum with explicit barrier synchronization
  * Shows the synchronization steps clearly
+ * 
+ * Uses one persistent parallel region; each level ends with an
+ * explicit `#pragma omp barrier` executed by the whole team.
  */
-int parallel_max_explicit_barriers(vector<int>& arr, int n) {
-    vector<int> temp(arr);
+int parallel_max_explicit_barriers(const int* arr, size_t n) {
+    vector<int> temp(arr, arr + n);
     
     // Calculate number of levels (synchronization steps)
     int levels = 0;
-    int temp_n = n;
+    size_t temp_n = n;
     while (temp_n > 1) {
         temp_n = (temp_n + 1) / 2;
         levels++;
     }
     
-    cout << "Number of synchronization steps: " << levels << endl;
+    if (debug_output) {
+        cout << "Number of synchronization steps: " << levels << endl;
+    }
+    
+    // Tree reduction with explicit barriers inside one persistent team
+    #pragma omp parallel
+    {
+        for (int level = 0; level < levels; level++) {
+            size_t stride = size_t(1) << level;  // 2^level
+            size_t step = stride * 2;
+            
+            {
+                TRACE_SCOPE_ARG("level", level);
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i += step) {
+                    if (i + stride < n) {
+                        temp[i] = max(temp[i], temp[i + stride]);
+                    }
+                }
+            }
+            
+            // Synchronization step: the level is complete for every thread
+            #pragma omp barrier
+            
+            if (debug_output) {
+                #pragma omp single
+                {
+                    cout << "After level " << level << " (stride=" << stride << "): ";
+                    for (size_t i = 0; i < min<size_t>(n, 16); i++) {
+                        cout << temp[i] << " ";
+                    }
+                    cout << endl;
+                }
+                // Implicit barrier at end of single: nobody starts the next
+                // level while the state is being printed
+            }
+        }
+    }
     
-    // Tree reduction with explicit barriers
-    for (int level = 0; level < levels; level++) {
-        int stride = 1 << level;  // 2^level
-        int step = stride * 2;
+    return temp[0];
+}
+
+/**
+ * Method 5: Parallel Maximum with runtime-dispatched SIMD kernels
+ * Each thread scans its chunk with the widest vector ISA available
+ * (SSE4.1, AVX2 or AVX-512), selected once at startup via CPUID
+ * (see cpu_features.h).
+ * Four independent vector accumulators per thread hide the latency
+ * of the max instruction, so each thread is bandwidth-bound.
+ *
+ * Time Complexity: O(N) work, O(N/(P*W) + log P) span (W = vector width)
+ */
+int max_kernel_scalar(const int* data, size_t n) {
+    int m0 = INT_MIN, m1 = INT_MIN, m2 = INT_MIN, m3 = INT_MIN;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        m0 = max(m0, data[i]);
+        m1 = max(m1, data[i + 1]);
+        m2 = max(m2, data[i + 2]);
+        m3 = max(m3, data[i + 3]);
+    }
+    for (; i < n; i++) m0 = max(m0, data[i]);
+    return max(max(m0, m1), max(m2, m3));
+}
+
+#if SIMD_X86
+__attribute__((target("sse4.1")))
+int max_kernel_sse41(const int* data, size_t n) {
+    __m128i m0 = _mm_set1_epi32(INT_MIN), m1 = m0, m2 = m0, m3 = m0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        m0 = _mm_max_epi32(m0, _mm_loadu_si128((const __m128i*)(data + i)));
+        m1 = _mm_max_epi32(m1, _mm_loadu_si128((const __m128i*)(data + i + 4)));
+        m2 = _mm_max_epi32(m2, _mm_loadu_si128((const __m128i*)(data + i + 8)));
+        m3 = _mm_max_epi32(m3, _mm_loadu_si128((const __m128i*)(data + i + 12)));
+    }
+    __m128i m = _mm_max_epi32(_mm_max_epi32(m0, m1), _mm_max_epi32(m2, m3));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    int max_val = _mm_cvtsi128_si32(m);
+    for (; i < n; i++) max_val = max(max_val, data[i]);
+    return max_val;
+}
+
+__attribute__((target("avx2")))
+int max_kernel_avx2(const int* data, size_t n) {
+    __m256i m0 = _mm256_set1_epi32(INT_MIN), m1 = m0, m2 = m0, m3 = m0;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        m0 = _mm256_max_epi32(m0, _mm256_loadu_si256((const __m256i*)(data + i)));
+        m1 = _mm256_max_epi32(m1, _mm256_loadu_si256((const __m256i*)(data + i + 8)));
+        m2 = _mm256_max_epi32(m2, _mm256_loadu_si256((const __m256i*)(data + i + 16)));
+        m3 = _mm256_max_epi32(m3, _mm256_loadu_si256((const __m256i*)(data + i + 24)));
+    }
+    __m256i m8 = _mm256_max_epi32(_mm256_max_epi32(m0, m1), _mm256_max_epi32(m2, m3));
+    __m128i m = _mm_max_epi32(_mm256_castsi256_si128(m8), _mm256_extracti128_si256(m8, 1));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    int max_val = _mm_cvtsi128_si32(m);
+    for (; i < n; i++) max_val = max(max_val, data[i]);
+    return max_val;
+}
+
+__attribute__((target("avx512f")))
+int max_kernel_avx512(const int* data, size_t n) {
+    __m512i m0 = _mm512_set1_epi32(INT_MIN), m1 = m0, m2 = m0, m3 = m0;
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        m0 = _mm512_max_epi32(m0, _mm512_loadu_si512(data + i));
+        m1 = _mm512_max_epi32(m1, _mm512_loadu_si512(data + i + 16));
+        m2 = _mm512_max_epi32(m2, _mm512_loadu_si512(data + i + 32));
+        m3 = _mm512_max_epi32(m3, _mm512_loadu_si512(data + i + 48));
+    }
+    __m512i m = _mm512_max_epi32(_mm512_max_epi32(m0, m1), _mm512_max_epi32(m2, m3));
+    if (i < n) {
+        // Masked load of the tail; inactive lanes keep INT_MIN
+        __mmask16 mask = (__mmask16)((1u << min<size_t>(n - i, 16)) - 1);
+        m = _mm512_max_epi32(m, _mm512_mask_loadu_epi32(_mm512_set1_epi32(INT_MIN), mask, data + i));
+        i += 16;
+    }
+    int max_val = _mm512_reduce_max_epi32(m);
+    for (; i < n; i++) max_val = max(max_val, data[i]);
+    return max_val;
+}
+#endif
+
+using MaxKernel = int (*)(const int*, size_t);
+
+MaxKernel select_max_kernel(SimdLevel level) {
+    switch (level) {
+#if SIMD_X86
+        case SimdLevel::AVX512: return max_kernel_avx512;
+        case SimdLevel::AVX2:   return max_kernel_avx2;
+        case SimdLevel::SSE41:  return max_kernel_sse41;
+#endif
+        default:                return max_kernel_scalar;
+    }
+}
+
+// Selected once at program startup
+const SimdLevel simd_level = detect_simd_level();
+const MaxKernel max_kernel = select_max_kernel(simd_level);
+
+int parallel_max_simd(const int* arr, size_t n) {
+    int max_val = INT_MIN;
+    
+    #pragma omp parallel reduction(max:max_val)
+    {
+        int tid = omp_get_thread_num();
+        int num_threads = omp_get_num_threads();
+        // Chunks are rounded to 16 ints so no two threads share a cache line
+        size_t chunk_size = ((n + num_threads - 1) / num_threads + 15) & ~size_t(15);
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
         
-        #pragma omp parallel for
-        for (int i = 0; i < n; i += step) {
-            if (i + stride < n) {
-                temp[i] = max(temp[i], temp[i + stride]);
+        if (start < end) {
+            TRACE_SCOPE("simd-chunk");
+            max_val = max_kernel(arr + start, end - start);
+        }
+    }
+    
+    return max_val;
+}
+
+/**
+ * NUMA-aware maximum: the Method 5 kernel over the static_chunk
+ * partition (the same one NumaArray places pages with), then a
+ * hierarchical combine. The lowest thread of each node merges the
+ * partials of its node's threads, and one thread merges the per-node
+ * maxima, so only one value per node crosses the interconnect.
+ */
+struct alignas(64) PaddedMax {
+    int value = INT_MIN;
+};
+
+int parallel_max_numa(const int* arr, size_t n) {
+    int num_threads = omp_get_max_threads();
+    int num_nodes = numa_node_count();
+    vector<PaddedMax> thread_max(num_threads);
+    vector<PaddedMax> node_max(num_nodes);
+    vector<int> thread_node(num_threads, 0);
+    int max_val = INT_MIN;
+    
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start, end;
+        static_chunk(n, tid, num_threads, start, end);
+        if (start < end) {
+            TRACE_SCOPE("numa-chunk");
+            thread_max[tid].value = max_kernel(arr + start, end - start);
+        }
+        thread_node[tid] = min(current_numa_node(), num_nodes - 1);
+        
+        #pragma omp barrier
+        
+        // Node leaders combine the partials of their node
+        int node = thread_node[tid];
+        bool leader = true;
+        for (int t = 0; t < tid; t++) leader = leader && thread_node[t] != node;
+        if (leader) {
+            TRACE_SCOPE("node-combine");
+            int m = INT_MIN;
+            for (int t = tid; t < num_threads; t++) {
+                if (thread_node[t] == node) m = max(m, thread_max[t].value);
             }
+            node_max[node].value = m;
         }
         
         #pragma omp barrier
         
-        cout << "After level " << level << " (stride=" << stride << "): ";
-        for (int i = 0; i < min(n, 16); i++) {
-            cout << temp[i] << " ";
+        #pragma omp single
+        for (int d = 0; d < num_nodes; d++) max_val = max(max_val, node_max[d].value);
+    }
+    
+    return max_val;
+}
+
+/**
+ * Generic Reduction Engine: parallel_reduce over any element type and
+ * any associative operator (monoid)
+ * 
+ * A monoid is a type with identity() and an associative operator()(a, b);
+ * the built-in ones live in monoids.h. Partial results are combined in
+ * thread order, so the operator does not need to be commutative. The
+ * built-in monoids are dispatched at
+ * compile time to a SIMD kernel (runtime-selected ISA, like Method 5);
+ * user-defined monoids run a plain loop per thread.
+ * 
+ * Works directly on int16, int64, float, double... columns through a
+ * pointer and a size, without copying them into a vector<int>.
+ */
+// Built-in monoids over arithmetic types get the SIMD kernels
+template <typename Op> struct is_simd_monoid : false_type {};
+template <typename T> struct is_simd_monoid<MaxOp<T>> : is_arithmetic<T> {};
+template <typename T> struct is_simd_monoid<MinOp<T>> : is_arithmetic<T> {};
+template <typename T> struct is_simd_monoid<SumOp<T>> : is_arithmetic<T> {};
+template <typename T> struct is_simd_monoid<BitAndOp<T>> : is_integral<T> {};
+template <typename T> struct is_simd_monoid<BitOrOp<T>> : is_integral<T> {};
+template <typename T> struct is_simd_monoid<BitXorOp<T>> : is_integral<T> {};
+
+/**
+ * Independent accumulators covering four 512-bit vectors. The fixed-size
+ * inner loop is vectorized by the compiler with whatever ISA the calling
+ * kernel is compiled for, and the accumulators hide the op latency.
+ */
+template <typename T, typename Op>
+inline __attribute__((always_inline)) T reduce_lanes(const T* data, size_t n, Op op) {
+    constexpr size_t LANES = 4 * 64 / sizeof(T);
+    T acc[LANES];
+    for (size_t j = 0; j < LANES; j++) acc[j] = op.identity();
+    
+    size_t i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (size_t j = 0; j < LANES; j++) {
+            acc[j] = op(acc[j], data[i + j]);
+        }
+    }
+    
+    T result = op.identity();
+    for (size_t j = 0; j < LANES; j++) result = op(result, acc[j]);
+    for (; i < n; i++) result = op(result, data[i]);
+    return result;
+}
+
+template <typename T, typename Op>
+T reduce_kernel_scalar(const T* data, size_t n, Op op) {
+    return reduce_lanes(data, n, op);
+}
+
+#if SIMD_X86
+template <typename T, typename Op>
+__attribute__((target("sse4.1")))
+T reduce_kernel_sse41(const T* data, size_t n, Op op) {
+    return reduce_lanes(data, n, op);
+}
+
+template <typename T, typename Op>
+__attribute__((target("avx2")))
+T reduce_kernel_avx2(const T* data, size_t n, Op op) {
+    return reduce_lanes(data, n, op);
+}
+
+template <typename T, typename Op>
+__attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+T reduce_kernel_avx512(const T* data, size_t n, Op op) {
+    return reduce_lanes(data, n, op);
+}
+#endif
+
+/**
+ * Reduces one contiguous chunk on the calling thread
+ */
+template <typename T, typename Op>
+T reduce_chunk(const T* data, size_t n, Op op) {
+    if constexpr (is_simd_monoid<Op>::value) {
+        switch (simd_level) {
+#if SIMD_X86
+            case SimdLevel::AVX512:
+                // The kernel is compiled for avx512bw/dq (int8/16 and int64
+                // ops) and avx512vl (which the compiler may use for the
+                // 128/256-bit tails), so all three must be present
+                if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq") &&
+                    __builtin_cpu_supports("avx512vl")) {
+                    return reduce_kernel_avx512(data, n, op);
+                }
+                return reduce_kernel_avx2(data, n, op);
+            case SimdLevel::AVX2:  return reduce_kernel_avx2(data, n, op);
+            case SimdLevel::SSE41: return reduce_kernel_sse41(data, n, op);
+#endif
+            default:               return reduce_kernel_scalar(data, n, op);
+        }
+    } else {
+        T result = op.identity();
+        for (size_t i = 0; i < n; i++) {
+            result = op(result, data[i]);
+        }
+        return result;
+    }
+}
+
+template <typename T, typename Op>
+T parallel_reduce(const T* data, size_t n, Op op) {
+    int max_threads = omp_get_max_threads();
+    vector<T> partial(max_threads, op.identity());
+    
+    #pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        int num_threads = omp_get_num_threads();
+        // Chunks are rounded to a cache line so threads do not share one
+        size_t per_line = max<size_t>(1, 64 / sizeof(T));
+        size_t chunk_size = ((n + num_threads - 1) / num_threads + per_line - 1) / per_line * per_line;
+        size_t start = min(n, tid * chunk_size);
+        size_t end = min(n, start + chunk_size);
+        
+        if (start < end) {
+            TRACE_SCOPE("reduce-chunk");
+            partial[tid] = reduce_chunk(data + start, end - start, op);
+        }
+    }
+    
+    // Combine in thread order (only associativity is required)
+    T result = op.identity();
+    for (int t = 0; t < max_threads; t++) {
+        result = op(result, partial[t]);
+    }
+    
+    return result;
+}
+
+template <typename T, typename Op>
+T parallel_reduce(const vector<T>& arr, Op op) {
+    return parallel_reduce(arr.data(), arr.size(), op);
+}
+
+/**
+ * Example of a user-defined monoid: minimum and maximum in one pass
+ */
+struct MinMax {
+    int min_val;
+    int max_val;
+};
+
+struct MinMaxOp {
+    MinMax identity() const { return {INT_MAX, INT_MIN}; }
+    MinMax operator()(MinMax a, MinMax b) const {
+        return {min(a.min_val, b.min_val), max(a.max_val, b.max_val)};
+    }
+};
+
+/**
+ * Argmax / Argmin: the value and the position of the maximum (minimum)
+ * 
+ * Every path carries ValueIndex pairs combined with ArgMaxOp / ArgMinOp
+ * (monoids.h), which prefer the larger (smaller) value and, on a tie,
+ * the lower index. That order is total, so the result is the first
+ * occurrence for any thread count, partition or combine order.
+ */
+
+// Reduction path: a user-defined OpenMP reduction over the pairs
+template <typename ArgOp>
+ValueIndex<int> parallel_arg_reduction(const int* arr, size_t n, ArgOp op) {
+    #pragma omp declare reduction(arg : ValueIndex<int> : omp_out = ArgOp()(omp_out, omp_in)) \
+        initializer(omp_priv = ArgOp().identity())
+    ValueIndex<int> best = op.identity();
+    
+    #pragma omp parallel for reduction(arg:best)
+    for (size_t i = 0; i < n; i++) {
+        best = op(best, {arr[i], i});
+    }
+    
+    return best;
+}
+
+// Tree path: Method 2 over (value, index) pairs
+template <typename ArgOp>
+ValueIndex<int> parallel_arg_tree(const int* arr, size_t n, ArgOp op) {
+    if (n == 0) return op.identity();
+    vector<ValueIndex<int>> temp(n);
+    
+    #pragma omp parallel
+    {
+        #pragma omp for
+        for (size_t i = 0; i < n; i++) {
+            temp[i] = {arr[i], i};
+        }
+        
+        size_t stride = 1;
+        for (int level = 0; stride < n; level++, stride *= 2) {
+            {
+                TRACE_SCOPE_ARG("tree-level", level);
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i += 2 * stride) {
+                    if (i + stride < n) {
+                        temp[i] = op(temp[i], temp[i + stride]);
+                    }
+                }
+            }
+            #pragma omp barrier
         }
-        cout << endl;
     }
     
     return temp[0];
 }
 
+// Sections path: one partial pair per thread, merged in thread order
+template <typename ArgOp>
+ValueIndex<int> parallel_arg_sections(const int* arr, size_t n, ArgOp op) {
+    int num_threads = omp_get_max_threads();
+    vector<ValueIndex<int>> partial(num_threads, op.identity());
+    
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start, end;
+        static_chunk(n, tid, num_threads, start, end);
+        
+        TRACE_SCOPE("chunk-arg");
+        ValueIndex<int> best = op.identity();
+        for (size_t i = start; i < end; i++) {
+            best = op(best, {arr[i], i});
+        }
+        partial[tid] = best;
+    }
+    
+    ValueIndex<int> best = op.identity();
+    for (int t = 0; t < num_threads; t++) {
+        best = op(best, partial[t]);
+    }
+    return best;
+}
+
+/**
+ * SIMD index tracking: each lane keeps its best value and the index it
+ * came from, replacing them only on a strictly better value so the lane
+ * holds its first occurrence. The lanes are merged with the same
+ * operator. Lane indices are int32, so the input is taken in slices of
+ * 2^30 elements.
+ */
+template <bool IsMax>
+using ArgOpFor = conditional_t<IsMax, ArgMaxOp<int>, ArgMinOp<int>>;
+
+template <bool IsMax>
+ValueIndex<int> arg_slice_scalar(const int* data, size_t n) {
+    ArgOpFor<IsMax> op;
+    ValueIndex<int> best = op.identity();
+    for (size_t i = 0; i < n; i++) best = op(best, {data[i], i});
+    return best;
+}
+
+#if SIMD_X86
+template <bool IsMax>
+__attribute__((target("avx2")))
+ValueIndex<int> arg_slice_avx2(const int* data, size_t n) {
+    ArgOpFor<IsMax> op;
+    ValueIndex<int> best = op.identity();
+    size_t i = 0;
+    if (n >= 8) {
+        __m256i best_v = _mm256_loadu_si256((const __m256i*)data);
+        __m256i best_i = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i step = _mm256_set1_epi32(8);
+        __m256i idx = _mm256_add_epi32(best_i, step);
+        for (i = 8; i + 8 <= n; i += 8) {
+            __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i better = IsMax ? _mm256_cmpgt_epi32(v, best_v) : _mm256_cmpgt_epi32(best_v, v);
+            best_v = _mm256_blendv_epi8(best_v, v, better);
+            best_i = _mm256_blendv_epi8(best_i, idx, better);
+            idx = _mm256_add_epi32(idx, step);
+        }
+        alignas(32) int values[8], indices[8];
+        _mm256_store_si256((__m256i*)values, best_v);
+        _mm256_store_si256((__m256i*)indices, best_i);
+        for (int lane = 0; lane < 8; lane++) best = op(best, {values[lane], (size_t)indices[lane]});
+    }
+    for (; i < n; i++) best = op(best, {data[i], i});
+    return best;
+}
+
+template <bool IsMax>
+__attribute__((target("avx512f")))
+ValueIndex<int> arg_slice_avx512(const int* data, size_t n) {
+    ArgOpFor<IsMax> op;
+    if (n < 16) return arg_slice_scalar<IsMax>(data, n);
+    
+    __m512i best_v = _mm512_loadu_si512(data);
+    __m512i best_i = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i idx = _mm512_add_epi32(best_i, step);
+    size_t i = 16;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_loadu_si512(data + i);
+        __mmask16 better = IsMax ? _mm512_cmpgt_epi32_mask(v, best_v) : _mm512_cmplt_epi32_mask(v, best_v);
+        best_v = _mm512_mask_mov_epi32(best_v, better, v);
+        best_i = _mm512_mask_mov_epi32(best_i, better, idx);
+        idx = _mm512_add_epi32(idx, step);
+    }
+    if (i < n) {
+        // Masked tail: inactive lanes are never "better"
+        __mmask16 mask = (__mmask16)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(mask, data + i);
+        __mmask16 better = IsMax ? _mm512_mask_cmpgt_epi32_mask(mask, v, best_v) : _mm512_mask_cmplt_epi32_mask(mask, v, best_v);
+        best_v = _mm512_mask_mov_epi32(best_v, better, v);
+        best_i = _mm512_mask_mov_epi32(best_i, better, idx);
+    }
+    
+    alignas(64) int values[16], indices[16];
+    _mm512_store_si512(values, best_v);
+    _mm512_store_si512(indices, best_i);
+    ValueIndex<int> best = op.identity();
+    for (int lane = 0; lane < 16; lane++) best = op(best, {values[lane], (size_t)indices[lane]});
+    return best;
+}
+#endif
+
+using ArgKernel = ValueIndex<int> (*)(const int*, size_t);
+
+template <bool IsMax, ArgKernel Slice>
+ValueIndex<int> arg_kernel_sliced(const int* data, size_t n) {
+    const size_t SLICE = size_t(1) << 30;
+    ArgOpFor<IsMax> op;
+    ValueIndex<int> best = op.identity();
+    for (size_t s = 0; s < n; s += SLICE) {
+        ValueIndex<int> r = Slice(data + s, min(SLICE, n - s));
+        r.index += s;
+        best = op(best, r);
+    }
+    return best;
+}
+
+template <bool IsMax>
+ArgKernel select_arg_kernel(SimdLevel level) {
+    switch (level) {
+#if SIMD_X86
+        case SimdLevel::AVX512: return arg_kernel_sliced<IsMax, arg_slice_avx512<IsMax>>;
+        case SimdLevel::AVX2:   return arg_kernel_sliced<IsMax, arg_slice_avx2<IsMax>>;
+#endif
+        default:                return arg_slice_scalar<IsMax>;
+    }
+}
+
+// SSE4.1 falls back to the scalar kernel, as the scan kernels do
+const ArgKernel argmax_kernel = select_arg_kernel<true>(simd_level);
+const ArgKernel argmin_kernel = select_arg_kernel<false>(simd_level);
+
+// SIMD path: the Method 5 partition with the index-tracking kernels
+template <typename ArgOp>
+ValueIndex<int> parallel_arg_simd(const int* arr, size_t n, ArgOp op, ArgKernel kernel) {
+    int num_threads = omp_get_max_threads();
+    vector<ValueIndex<int>> partial(num_threads, op.identity());
+    
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t chunk_size = ((n + num_threads - 1) / num_threads + 15) & ~size_t(15);
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
+        
+        if (start < end) {
+            TRACE_SCOPE("simd-arg-chunk");
+            ValueIndex<int> best = kernel(arr + start, end - start);
+            best.index += start;
+            partial[tid] = best;
+        }
+    }
+    
+    ValueIndex<int> best = op.identity();
+    for (int t = 0; t < num_threads; t++) {
+        best = op(best, partial[t]);
+    }
+    return best;
+}
+
+ValueIndex<int> parallel_argmax_reduction(const int* arr, size_t n) { return parallel_arg_reduction(arr, n, ArgMaxOp<int>()); }
+ValueIndex<int> parallel_argmax_tree(const int* arr, size_t n) { return parallel_arg_tree(arr, n, ArgMaxOp<int>()); }
+ValueIndex<int> parallel_argmax_sections(const int* arr, size_t n) { return parallel_arg_sections(arr, n, ArgMaxOp<int>()); }
+ValueIndex<int> parallel_argmax_simd(const int* arr, size_t n) { return parallel_arg_simd(arr, n, ArgMaxOp<int>(), argmax_kernel); }
+
+ValueIndex<int> parallel_argmin_reduction(const int* arr, size_t n) { return parallel_arg_reduction(arr, n, ArgMinOp<int>()); }
+ValueIndex<int> parallel_argmin_tree(const int* arr, size_t n) { return parallel_arg_tree(arr, n, ArgMinOp<int>()); }
+ValueIndex<int> parallel_argmin_sections(const int* arr, size_t n) { return parallel_arg_sections(arr, n, ArgMinOp<int>()); }
+ValueIndex<int> parallel_argmin_simd(const int* arr, size_t n) { return parallel_arg_simd(arr, n, ArgMinOp<int>(), argmin_kernel); }
+
+/**
+ * Top-k: the k largest values with their indices, best first (larger
+ * value first, lower index first among equal values)
+ * 
+ * Phase 1, per thread over its static chunk: a threshold filter. The
+ * thread keeps up to 2k candidates; once it holds k, only values above
+ * the current k-th best can enter. Blocks of 256 elements are first
+ * tested with the SIMD max kernel, so for small k almost every block is
+ * rejected at memory bandwidth. When the buffer fills, nth_element keeps
+ * the best k and raises the threshold. Chunks are scanned in index
+ * order, so a later value equal to the threshold can never beat it.
+ * 
+ * Phase 2: a tree merge of the sorted per-thread lists, log2(P) levels
+ * separated by barriers, each merge truncated to k.
+ * 
+ * Time Complexity: O(N) work (plus O(P k log k)), O(N/P + k log P) span
+ */
+inline bool better_candidate(const ValueIndex<int>& a, const ValueIndex<int>& b) {
+    return a.value > b.value || (a.value == b.value && a.index < b.index);
+}
+
+vector<ValueIndex<int>> parallel_top_k(const int* arr, size_t n, size_t k) {
+    k = min(k, n);
+    if (k == 0) return {};
+    
+    const size_t BLOCK = 256;
+    int num_threads = omp_get_max_threads();
+    vector<vector<ValueIndex<int>>> lists(num_threads);
+    
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start, end;
+        static_chunk(n, tid, num_threads, start, end);
+        
+        {
+            TRACE_SCOPE("topk-filter");
+            vector<ValueIndex<int>>& cand = lists[tid];
+            cand.reserve(2 * k);
+            int threshold = INT_MIN;  // Valid once cand holds k entries
+            
+            for (size_t b = start; b < end; b += BLOCK) {
+                size_t block_end = min(b + BLOCK, end);
+                if (cand.size() >= k && max_kernel(arr + b, block_end - b) <= threshold) continue;
+                
+                for (size_t i = b; i < block_end; i++) {
+                    if (cand.size() >= k && arr[i] <= threshold) continue;
+                    cand.push_back({arr[i], i});
+                    if (cand.size() == 2 * k) {
+                        nth_element(cand.begin(), cand.begin() + (k - 1), cand.end(), better_candidate);
+                        cand.resize(k);
+                        threshold = cand[k - 1].value;
+                    }
+                }
+            }
+            
+            size_t keep = min(k, cand.size());
+            partial_sort(cand.begin(), cand.begin() + keep, cand.end(), better_candidate);
+            cand.resize(keep);
+        }
+        
+        // Tree merge: at each level thread tid absorbs the list of tid + stride
+        for (int stride = 1; stride < num_threads; stride *= 2) {
+            #pragma omp barrier
+            if (tid % (2 * stride) == 0 && tid + stride < num_threads) {
+                TRACE_SCOPE_ARG("topk-merge", stride);
+                vector<ValueIndex<int>>& left = lists[tid];
+                vector<ValueIndex<int>>& right = lists[tid + stride];
+                vector<ValueIndex<int>> merged;
+                merged.reserve(min(k, left.size() + right.size()));
+                size_t a = 0, b = 0;
+                while (merged.size() < k && (a < left.size() || b < right.size())) {
+                    if (b == right.size() || (a < left.size() && better_candidate(left[a], right[b]))) {
+                        merged.push_back(left[a++]);
+                    } else {
+                        merged.push_back(right[b++]);
+                    }
+                }
+                left.swap(merged);
+            }
+        }
+    }
+    
+    return lists[0];
+}
+
+/**
+ * Sliding-window maximum (van Herk / Gil-Werman): out[i] = max of
+ * arr[i .. i+w-1] for the n-w+1 full windows
+ * 
+ * The outputs are cut into blocks of w. A window starting at i in block
+ * [s, s+w) is the suffix arr[i .. s+w-1] of the block plus the prefix
+ * arr[s+w .. i+w-1] of the next one. Each block therefore needs one
+ * backward pass for its suffix maxima (kept in a per-thread buffer of w
+ * ints) and one forward pass over the next block's running max, so every
+ * element is read about twice whatever w is. Blocks are independent and
+ * are split statically across the threads.
+ * 
+ * Time Complexity: O(N) work, O(N/P + w) span; parallel while the
+ * N/w blocks outnumber the threads
+ */
+void parallel_sliding_max(const int* arr, size_t n, size_t w, int* out) {
+    if (w == 0 || w > n) return;
+    size_t outputs = n - w + 1;
+    size_t num_blocks = (outputs + w - 1) / w;
+    
+    #pragma omp parallel
+    {
+        vector<int> suffix(min(w, outputs));
+        
+        #pragma omp for schedule(static)
+        for (size_t b = 0; b < num_blocks; b++) {
+            TRACE_SCOPE("window-block");
+            size_t s = b * w;
+            size_t e = min(s + w, outputs);
+            
+            // Suffix maxima of arr[i .. s+w-1] for the block's own outputs
+            int m = INT_MIN;
+            for (size_t i = s + w; i-- > e;) m = max(m, arr[i]);
+            for (size_t i = e; i-- > s;) {
+                m = max(m, arr[i]);
+                suffix[i - s] = m;
+            }
+            
+            // Running prefix maximum of the next block
+            out[s] = suffix[0];
+            m = INT_MIN;
+            for (size_t i = s + 1; i < e; i++) {
+                m = max(m, arr[i + w - 1]);
+                out[i] = max(suffix[i - s], m);
+            }
+        }
+    }
+}
+
+vector<int> parallel_sliding_max(const int* arr, size_t n, size_t w) {
+    vector<int> out((w == 0 || w > n) ? 0 : n - w + 1);
+    parallel_sliding_max(arr, n, w, out.data());
+    return out;
+}
+
+/**
+ * Segmented Reductions: one result per segment of a packed array, in a
+ * single parallel region instead of one parallel_reduce per segment
+ * 
+ * Segments are given as CSR offsets or head flags (segments.h). The
+ * elements, not the segments, are split with static_chunk, so every
+ * thread gets the same amount of work however the lengths are skewed:
+ *   - A thread reduces every segment that starts in its chunk (up to the
+ *     chunk end) and writes it to out directly. Empty segments get the
+ *     identity; the last chunk also owns the empty segments at n.
+ *   - The elements before the first segment start in the chunk continue
+ *     a segment owned by an earlier thread; their partial is kept and
+ *     folded in afterwards, in thread order, so only associativity is
+ *     required.
+ * Long pieces of built-in monoids use the SIMD kernels of parallel_reduce.
+ * 
+ * Time Complexity: O(N + S) work, O(N/P + log S + P) span
+ */
+template <typename T, typename Op, typename Acc = decltype(declval<Op>().identity())>
+Acc reduce_segment_piece(const T* data, size_t n, Op op) {
+    if constexpr (is_same<Acc, T>::value) {
+        if (n >= 256) return reduce_chunk(data, n, op);
+    }
+    Acc acc = op.identity();
+    for (size_t i = 0; i < n; i++) {
+        acc = op(acc, Acc(data[i]));
+    }
+    return acc;
+}
+
+template <typename T, typename Op, typename Acc>
+void parallel_segmented_reduce(const T* data, const size_t* offsets, size_t num_segments, Op op, Acc* out) {
+    if (num_segments == 0) return;
+    size_t n = offsets[num_segments];
+    const size_t* offsets_end = offsets + num_segments;
+    
+    int num_threads = omp_get_max_threads();
+    const size_t NONE = numeric_limits<size_t>::max();
+    vector<size_t> carry_segment(num_threads, NONE);
+    vector<Acc> carry_value(num_threads, op.identity());
+    
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start, end;
+        static_chunk(n, tid, num_threads, start, end);
+        
+        // Segments starting in [start, end); the chunk holding element
+        // n-1 (thread 0 if n == 0) also takes the trailing empty ones
+        bool owns_tail = (n == 0) ? tid == 0 : (start < end && end == n);
+        size_t first = lower_bound(offsets, offsets_end, start) - offsets;
+        size_t last = owns_tail ? num_segments : lower_bound(offsets, offsets_end, end) - offsets;
+        if (start == end && !owns_tail) first = last;
+        
+        if (start < end) {
+            TRACE_SCOPE("segment-chunk");
+            size_t piece_end = (first < num_segments) ? min(offsets[first], end) : end;
+            if (start < piece_end) {
+                carry_segment[tid] = first - 1;
+                carry_value[tid] = reduce_segment_piece(data + start, piece_end - start, op);
+            }
+        }
+        for (size_t s = first; s < last; s++) {
+            size_t seg_end = min(offsets[s + 1], end);
+            out[s] = reduce_segment_piece(data + offsets[s], seg_end - offsets[s], op);
+        }
+    }
+    
+    // Segments crossing chunk boundaries, combined left to right
+    for (int t = 0; t < num_threads; t++) {
+        if (carry_segment[t] != NONE) {
+            out[carry_segment[t]] = op(out[carry_segment[t]], carry_value[t]);
+        }
+    }
+}
+
+template <typename T, typename Op, typename Acc>
+void parallel_segmented_reduce(const T* data, const uint8_t* flags, size_t n, Op op, vector<Acc>& out) {
+    vector<size_t> offsets = segment_offsets_from_flags(flags, n);
+    out.resize(offsets.size() - 1);
+    parallel_segmented_reduce(data, offsets.data(), offsets.size() - 1, op, out.data());
+}
+
+/**
+ * Segment maxima (INT_MIN for empty segments) and segment sums
+ * (accumulated in 64 bits, so long segments cannot overflow)
+ */
+vector<int> parallel_segmented_max(const int* arr, const size_t* offsets, size_t num_segments) {
+    vector<int> out(num_segments);
+    parallel_segmented_reduce(arr, offsets, num_segments, MaxOp<int>(), out.data());
+    return out;
+}
+
+vector<int> parallel_segmented_max(const int* arr, const uint8_t* flags, size_t n) {
+    vector<int> out;
+    parallel_segmented_reduce(arr, flags, n, MaxOp<int>(), out);
+    return out;
+}
+
+vector<int64_t> parallel_segmented_sum(const int* arr, const size_t* offsets, size_t num_segments) {
+    vector<int64_t> out(num_segments);
+    parallel_segmented_reduce(arr, offsets, num_segments, SumOp<int64_t>(), out.data());
+    return out;
+}
+
+vector<int64_t> parallel_segmented_sum(const int* arr, const uint8_t* flags, size_t n) {
+    vector<int64_t> out;
+    parallel_segmented_reduce(arr, flags, n, SumOp<int64_t>(), out);
+    return out;
+}
+
+/**
+ * Range-Max Index: O(1) maximum over any [begin, end) of a fixed array,
+ * built in parallel (block-decomposed sparse table)
+ * 
+ * The array is cut into blocks of 32:
+ *   - In-block: mask[i] marks the positions of i's block, up to i, whose
+ *     value is not exceeded by any later one up to i (a monotonic stack
+ *     as a bitmask). The maximum of [j, i] inside a block is then at the
+ *     lowest bit of mask[i] at or above j: one AND and one count of
+ *     trailing zeros.
+ *   - Across blocks: a sparse table over the block maxima, level k
+ *     holding the maximum of 2^k consecutive blocks, so any run of whole
+ *     blocks is covered by two overlapping entries.
+ * A query combines at most two in-block lookups and two table entries.
+ * Memory: 4 bytes per element for the masks plus 4*(N/32)*log2(N/32)
+ * for the table, instead of 4*N*log2(N) for a plain sparse table.
+ * 
+ * Build: every block's masks and maximum in parallel (one pass over the
+ * input at memory bandwidth), then one parallel pass per table level.
+ * The index keeps a pointer to the array, which must stay alive and
+ * unchanged while the index is used.
+ * 
+ * Time Complexity: O(N) build work, O(N/P + log N) build span, O(1) query
+ */
+struct RangeQuery {
+    size_t begin;
+    size_t end;
+};
+
+class RangeMaxIndex {
+public:
+    static constexpr size_t BLOCK = 32;
+    
+    RangeMaxIndex() = default;
+    RangeMaxIndex(const int* arr, size_t n) { build(arr, n); }
+    
+    void build(const int* arr, size_t n) {
+        arr_ = arr;
+        n_ = n;
+        num_blocks_ = (n + BLOCK - 1) / BLOCK;
+        levels_ = 1;
+        while ((size_t(1) << levels_) <= num_blocks_) levels_++;
+        masks_.resize(n);
+        table_.resize(levels_ * num_blocks_);
+        
+        #pragma omp parallel
+        {
+            {
+                TRACE_SCOPE("index-blocks");
+                #pragma omp for schedule(static)
+                for (size_t b = 0; b < num_blocks_; b++) {
+                    size_t start = b * BLOCK;
+                    size_t len = min(BLOCK, n - start);
+                    uint32_t stack = 0;
+                    int block_max = INT_MIN;
+                    for (size_t j = 0; j < len; j++) {
+                        int value = arr[start + j];
+                        // Pop the later positions with smaller values
+                        while (stack && arr[start + 31 - __builtin_clz(stack)] < value) {
+                            stack ^= 1u << (31 - __builtin_clz(stack));
+                        }
+                        stack |= 1u << j;
+                        masks_[start + j] = stack;
+                        block_max = max(block_max, value);
+                    }
+                    table_[b] = block_max;
+                }
+            }
+            
+            // Level k from level k-1: the blocks [b, b + 2^k) as two halves
+            for (size_t k = 1; k < levels_; k++) {
+                TRACE_SCOPE_ARG("index-level", k);
+                const int* prev = table_.data() + (k - 1) * num_blocks_;
+                int* cur = table_.data() + k * num_blocks_;
+                size_t half = size_t(1) << (k - 1);
+                size_t count = num_blocks_ - (size_t(1) << k) + 1;
+                #pragma omp for schedule(static)
+                for (size_t b = 0; b < count; b++) {
+                    cur[b] = max(prev[b], prev[b + half]);
+                }
+            }
+        }
+    }
+    
+    size_t size() const { return n_; }
+    
+    /**
+     * Maximum of [begin, end); INT_MIN if the range is empty
+     */
+    int query(size_t begin, size_t end) const {
+        if (begin >= end) return INT_MIN;
+        size_t last = end - 1;
+        size_t first_block = begin / BLOCK;
+        size_t last_block = last / BLOCK;
+        if (first_block == last_block) return in_block(begin, last);
+        
+        int result = max(in_block(begin, first_block * BLOCK + BLOCK - 1), in_block(last_block * BLOCK, last));
+        if (first_block + 1 < last_block) {
+            result = max(result, blocks(first_block + 1, last_block));
+        }
+        return result;
+    }
+    
+    int query(RangeQuery q) const { return query(q.begin, q.end); }
+    
+    /**
+     * Answers a batch of queries, split statically across the threads
+     */
+    void query_batch(const RangeQuery* queries, size_t count, int* out) const {
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < count; i++) {
+            out[i] = query(queries[i]);
+        }
+    }
+    
+    vector<int> query_batch(const vector<RangeQuery>& queries) const {
+        vector<int> out(queries.size());
+        query_batch(queries.data(), queries.size(), out.data());
+        return out;
+    }
+    
+private:
+    const int* arr_ = nullptr;
+    size_t n_ = 0;
+    size_t num_blocks_ = 0;
+    size_t levels_ = 0;
+    vector<uint32_t, default_init_allocator<uint32_t>> masks_;
+    vector<int, default_init_allocator<int>> table_;  // levels_ rows of num_blocks_
+    
+    // Maximum of [first, last] inside one block
+    int in_block(size_t first, size_t last) const {
+        uint32_t stack = masks_[last] & (~0u << (first % BLOCK));
+        return arr_[last - last % BLOCK + __builtin_ctz(stack)];
+    }
+    
+    // Maximum of the whole blocks [first, last)
+    int blocks(size_t first, size_t last) const {
+        size_t k = 63 - __builtin_clzll(last - first);
+        const int* row = table_.data() + k * num_blocks_;
+        return max(row[first], row[last - (size_t(1) << k)]);
+    }
+};
+
+/**
+ * Maximum over many files (shards) of raw or headered int32, read by the
+ * io_uring reader (see uring_reader.h). Every completed block goes
+ * straight to parallel_max_simd while the other reads stay in flight,
+ * and the per-block maxima are merged per shard and then overall.
+ */
+struct ShardMax {
+    int max_val = INT_MIN;
+    size_t count = 0;  // Elements read from the shard
+};
+
+bool parallel_max_shards(const vector<string>& paths, const ShardReadOptions& options, vector<ShardMax>& shards,
+                         int& overall, ShardReadStats& stats, string& error) {
+    shards.assign(paths.size(), ShardMax());
+    
+    auto consume = [&](const ShardBlock& block) {
+        const char* data = block.data;
+        size_t bytes = block.bytes;
+        
+        // Headered shards carry the ArrayFileHeader of mapped_array.h. Only
+        // the first block of a shard can hold it, so this runs once per
+        // shard; a shard starting with the magic must match the header
+        // exactly (int32 elements, count filling the file) or is rejected
+        ArrayFileHeader header;
+        if (block.offset == 0 && bytes >= sizeof(header) && memcmp(data, ARRAY_FILE_MAGIC, 4) == 0) {
+            memcpy(&header, data, sizeof(header));
+            uint64_t payload = block.file_size - sizeof(header);
+            if (header.element_size != sizeof(int) || payload % sizeof(int) != 0 || header.count != payload / sizeof(int)) {
+                error = paths[block.shard] + ": starts with the PARR magic but the header does not match "
+                        "int32 elements and the file size";
+                return false;
+            }
+            data += sizeof(header);
+            bytes -= sizeof(header);
+        }
+        if (bytes % sizeof(int) != 0) {
+            error = paths[block.shard] + ": size is not a multiple of 4 bytes";
+            return false;
+        }
+        
+        size_t count = bytes / sizeof(int);
+        if (count == 0) return true;
+        ShardMax& shard = shards[block.shard];
+        shard.max_val = max(shard.max_val, parallel_max_simd(reinterpret_cast<const int*>(data), count));
+        shard.count += count;
+        return true;
+    };
+    
+    if (!read_shards(paths, options, consume, stats, error)) return false;
+    
+    overall = INT_MIN;
+    size_t total = 0;
+    for (const ShardMax& shard : shards) {
+        if (shard.count > 0) overall = max(overall, shard.max_val);
+        total += shard.count;
+    }
+    if (total == 0) {
+        error = "the shards contain no elements";
+        return false;
+    }
+    return true;
+}
+
 /**
  * Sequential maximum for comparison
  */
-int sequential_max(const vector<int>& arr, int n) {
+int sequential_max(const int* arr, size_t n) {
     int max_val = INT_MIN;
-    for (int i = 0; i < n; i++) {
+    for (size_t i = 0; i < n; i++) {
         if (arr[i] > max_val) {
             max_val = arr[i];
         }
@@ -154,21 +1222,342 @@ int sequential_max(const vector<int>& arr, int n) {
     return max_val;
 }
 
+/**
+ * Sequential argmax/argmin (first occurrence) for comparison
+ */
+ValueIndex<int> sequential_argmax(const int* arr, size_t n) {
+    ValueIndex<int> best = ArgMaxOp<int>().identity();
+    for (size_t i = 0; i < n; i++) {
+        if (arr[i] > best.value || best.index == SIZE_MAX) best = {arr[i], i};
+    }
+    return best;
+}
+
+ValueIndex<int> sequential_argmin(const int* arr, size_t n) {
+    ValueIndex<int> best = ArgMinOp<int>().identity();
+    for (size_t i = 0; i < n; i++) {
+        if (arr[i] < best.value || best.index == SIZE_MAX) best = {arr[i], i};
+    }
+    return best;
+}
+
+/**
+ * Sequential top-k with a size-k heap whose top is the worst kept entry
+ */
+vector<ValueIndex<int>> sequential_top_k(const int* arr, size_t n, size_t k) {
+    k = min(k, n);
+    vector<ValueIndex<int>> heap;
+    if (k == 0) return heap;
+    heap.reserve(k);
+    for (size_t i = 0; i < n; i++) {
+        ValueIndex<int> x = {arr[i], i};
+        if (heap.size() < k) {
+            heap.push_back(x);
+            push_heap(heap.begin(), heap.end(), better_candidate);
+        } else if (better_candidate(x, heap.front())) {
+            pop_heap(heap.begin(), heap.end(), better_candidate);
+            heap.back() = x;
+            push_heap(heap.begin(), heap.end(), better_candidate);
+        }
+    }
+    sort_heap(heap.begin(), heap.end(), better_candidate);
+    return heap;
+}
+
+/**
+ * Sequential sliding-window maximum with a monotonic deque of indices
+ * whose values decrease from front to back
+ */
+vector<int> sequential_sliding_max(const int* arr, size_t n, size_t w) {
+    vector<int> out;
+    if (w == 0 || w > n) return out;
+    out.reserve(n - w + 1);
+    deque<size_t> window;
+    for (size_t i = 0; i < n; i++) {
+        while (!window.empty() && arr[window.back()] <= arr[i]) window.pop_back();
+        window.push_back(i);
+        if (window.front() + w <= i) window.pop_front();
+        if (i + 1 >= w) out.push_back(arr[window.front()]);
+    }
+    return out;
+}
+
+/**
+ * Serial segmented reduction over CSR offsets, used as the reference
+ */
+template <typename T, typename Op, typename Acc = decltype(declval<Op>().identity())>
+vector<Acc> sequential_segmented_reduce(const T* arr, const size_t* offsets, size_t num_segments, Op op) {
+    vector<Acc> out(num_segments, op.identity());
+    for (size_t s = 0; s < num_segments; s++) {
+        for (size_t i = offsets[s]; i < offsets[s + 1]; i++) {
+            out[s] = op(out[s], Acc(arr[i]));
+        }
+    }
+    return out;
+}
+
 /**
  * Function to print array
  */
-void print_array(const vector<int>& arr, const string& name) {
+void print_array(const int* arr, size_t n, const string& name) {
     cout << name << ": [";
-    for (size_t i = 0; i < arr.size(); i++) {
+    for (size_t i = 0; i < n; i++) {
         cout << arr[i];
-        if (i < arr.size() - 1) cout << ", ";
+        if (i < n - 1) cout << ", ";
     }
     cout << "]" << endl;
 }
 
-int main() {
-    // Seed for random number generation
-    srand(time(NULL));
+/**
+ * Checks a parallel method against its serial reference with 1, 3 (so
+ * the chunks are uneven) and the current number of threads, which is
+ * restored afterwards
+ */
+template <typename Method, typename Reference>
+bool matches_reference(Method method, Reference reference) {
+    int num_threads = omp_get_max_threads();
+    auto expected = reference();
+    bool same = true;
+    for (int threads : {1, 3, num_threads}) {
+        omp_set_num_threads(threads);
+        same = same && method() == expected;
+    }
+    omp_set_num_threads(num_threads);
+    return same;
+}
+
+/**
+ * Benchmark mode: runs the methods selected on the command line
+ * (see benchmark.h) instead of the interactive demo
+ */
+int benchmark_main(int argc, char** argv) {
+    BenchmarkOptions opts;
+    string error;
+    if (!parse_benchmark_options(argc, argv, opts, error)) {
+        if (!error.empty()) cerr << "Error: " << error << endl;
+        print_benchmark_usage(argv[0]);
+        return error.empty() ? 0 : 1;
+    }
+    
+    debug_output = false;
+    
+    if (!opts.output_path.empty()) {
+        cerr << "Error: --output only applies to the scans" << endl;
+        return 1;
+    }
+    
+    // Input: generated from the seed, or a memory-mapped file used in place
+    NumaArray<int> generated;
+    NumaArray<int> windows;  // Sliding-window output, placed like the input
+    MappedArray<int> mapped;
+    if (!opts.input_path.empty()) {
+        if (!mapped.open(opts.input_path, benchmark_map_options(opts), error)) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        opts.sizes = {mapped.size()};
+    }
+    
+    const int* arr = nullptr;
+    size_t count = 0;
+    int expected = 0;
+    int result = 0;
+    ValueIndex<int> expected_argmax, expected_argmin, arg_result;
+    const size_t TOP_K = 100;
+    vector<ValueIndex<int>> expected_top, top_result;
+    const size_t WINDOW = 1000;
+    vector<int> expected_windows;
+    const size_t SEGMENT_LENGTH = 32;  // Mean length of the segmented_max groups
+    vector<size_t> segment_offsets;
+    vector<int> expected_segments, segment_result;
+    // Range queries with random endpoints; a sample is checked against a
+    // direct reduction, since checking all of them costs O(N) each
+    const size_t QUERIES = size_t(1) << 20;
+    const size_t QUERY_SAMPLE = 64;
+    vector<RangeQuery> queries;
+    vector<int> expected_sample, query_result(QUERIES);
+    RangeMaxIndex range_index, built_index;
+    
+    auto prepare = [&](size_t n, uint64_t seed) {
+        if (mapped.size() > 0) {
+            arr = mapped.data();
+        } else {
+            // Pages placed with the threads that read them (--numa)
+            generated.allocate(n, opts.numa);
+            fill_input(generated.data(), n, opts.distribution, seed, 0, 999);  // Same range as the interactive mode
+            arr = generated.data();
+        }
+        count = n;
+        expected = sequential_max(arr, n);
+        expected_argmax = sequential_argmax(arr, n);
+        expected_argmin = sequential_argmin(arr, n);
+        expected_top = sequential_top_k(arr, n, TOP_K);
+        expected_windows = sequential_sliding_max(arr, n, WINDOW);
+        windows.allocate(expected_windows.size(), opts.numa);
+        segment_offsets = random_segment_offsets(n, SEGMENT_LENGTH, seed);
+        expected_segments = sequential_segmented_reduce(arr, segment_offsets.data(), segment_offsets.size() - 1, MaxOp<int>());
+        
+        queries.resize(QUERIES);
+        for (size_t q = 0; q < QUERIES; q++) {
+            size_t a = bounded_random(counter_random(seed + 1, 2 * q), n);
+            size_t b = bounded_random(counter_random(seed + 1, 2 * q + 1), n) + 1;
+            queries[q] = {min(a, b - 1), max(a + 1, b)};
+        }
+        expected_sample.clear();
+        for (size_t q = 0; q < QUERIES; q += QUERIES / QUERY_SAMPLE) {
+            expected_sample.push_back(parallel_max_simd(arr + queries[q].begin, queries[q].end - queries[q].begin));
+        }
+        range_index.build(arr, n);
+    };
+    auto check = [&]() { return result == expected; };
+    auto check_argmax = [&]() { return arg_result.index == expected_argmax.index; };
+    auto check_argmin = [&]() { return arg_result.index == expected_argmin.index; };
+    auto check_top = [&]() {
+        return top_result.size() == expected_top.size() &&
+               equal(top_result.begin(), top_result.end(), expected_top.begin(),
+                     [](ValueIndex<int> a, ValueIndex<int> b) { return a.value == b.value && a.index == b.index; });
+    };
+    auto check_index = [&]() {
+        for (size_t s = 0; s < QUERY_SAMPLE; s++) {
+            if (built_index.query(queries[s * (QUERIES / QUERY_SAMPLE)]) != expected_sample[s]) return false;
+        }
+        return true;
+    };
+    auto check_queries = [&]() {
+        for (size_t s = 0; s < QUERY_SAMPLE; s++) {
+            if (query_result[s * (QUERIES / QUERY_SAMPLE)] != expected_sample[s]) return false;
+        }
+        return true;
+    };
+    auto check_windows = [&]() {
+        return windows.size() == expected_windows.size() && equal(windows.begin(), windows.end(), expected_windows.begin());
+    };
+    
+    // Compulsory traffic: one int read per element (the default 4 bytes),
+    // plus one int written per window for the sliding maximum, and one
+    // offset read and one int written per segment for the segmented maximum.
+    // The index build also writes one mask per element; the queries have no
+    // per-element traffic
+    
+    vector<BenchmarkMethod> methods = {
+        {"reduction", [&]() { result = parallel_max_reduction(arr, count); }, check},
+        {"tree", [&]() { result = parallel_max_tree_reduction(arr, count); }, check},
+        {"sections", [&]() { result = parallel_max_sections(arr, count); }, check},
+        {"barriers", [&]() { result = parallel_max_explicit_barriers(arr, count); }, check},
+        {"simd", [&]() { result = parallel_max_simd(arr, count); }, check},
+        {"numa", [&]() { result = parallel_max_numa(arr, count); }, check},
+        {"generic", [&]() { result = parallel_reduce(arr, count, MaxOp<int>()); }, check},
+        {"argmax_reduction", [&]() { arg_result = parallel_argmax_reduction(arr, count); }, check_argmax},
+        {"argmax_tree", [&]() { arg_result = parallel_argmax_tree(arr, count); }, check_argmax},
+        {"argmax_sections", [&]() { arg_result = parallel_argmax_sections(arr, count); }, check_argmax},
+        {"argmax_simd", [&]() { arg_result = parallel_argmax_simd(arr, count); }, check_argmax},
+        {"argmin_simd", [&]() { arg_result = parallel_argmin_simd(arr, count); }, check_argmin},
+        {"topk", [&]() { top_result = parallel_top_k(arr, count, TOP_K); }, check_top},
+        {"sliding", [&]() { parallel_sliding_max(arr, count, WINDOW, windows.data()); }, check_windows, 8},
+        {"segmented_max", [&]() {
+            segment_result = parallel_segmented_max(arr, segment_offsets.data(), segment_offsets.size() - 1);
+        }, [&]() { return segment_result == expected_segments; }, 4 + 12.0 / SEGMENT_LENGTH},
+        {"range_build", [&]() { built_index.build(arr, count); }, check_index, 8},
+        {"range_query", [&]() { range_index.query_batch(queries.data(), QUERIES, query_result.data()); }, check_queries, 0},
+        {"sequential", [&]() { result = sequential_max(arr, count); }, check},
+    };
+    
+    return run_benchmark(opts, methods, prepare, cout);
+}
+
+/**
+ * Shard mode: maximum over a list of files, e.g.
+ *     ./parallel_maximum --shards --depth=64 --direct shard0.bin shard1.bin ...
+ * A path starting with @ names a text file with one path per line.
+ */
+int shards_main(int argc, char** argv) {
+    ShardReadOptions options;
+    vector<string> paths;
+    bool verbose = false;
+    
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        size_t value = 0;
+        if (arg.rfind("--depth=", 0) == 0 && parse_size(arg.substr(8), value) && value > 0 && value <= 4096) {
+            options.queue_depth = (unsigned)value;
+        } else if (arg.rfind("--block=", 0) == 0 && parse_size(arg.substr(8), value) && value > 0 && value <= (1u << 30)) {
+            options.block_size = value;
+        } else if (arg == "--direct") {
+            options.direct = true;
+        } else if (arg == "--register") {
+            options.register_buffers = true;
+        } else if (arg == "--no-uring") {
+            options.use_uring = false;
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg[0] == '@') {
+            ifstream list(arg.substr(1));
+            if (!list) {
+                cerr << "Error: cannot read the shard list " << arg.substr(1) << endl;
+                return 1;
+            }
+            for (string line; getline(list, line);) {
+                if (!line.empty()) paths.push_back(line);
+            }
+        } else if (arg.rfind("--", 0) != 0) {
+            paths.push_back(arg);
+        } else {
+            cerr << "Error: unknown or invalid option " << arg << endl;
+            paths.clear();
+            break;
+        }
+    }
+    if (paths.empty()) {
+        cerr << "Usage: " << argv[0] << " --shards [options] file... | @list.txt\n"
+             << "  --depth=N     Reads in flight, default 32\n"
+             << "  --block=N     Bytes per read (K/M/G suffixes allowed), default 1048576\n"
+             << "  --direct      Open the shards with O_DIRECT\n"
+             << "  --register    Register the read buffers with io_uring\n"
+             << "  --no-uring    Use synchronous pread instead of io_uring\n"
+             << "  --verbose     Print the maximum of every shard" << endl;
+        return 1;
+    }
+    
+    debug_output = false;
+    
+    vector<ShardMax> shards;
+    int overall = 0;
+    ShardReadStats stats;
+    string error;
+    double start = omp_get_wtime();
+    bool ok = parallel_max_shards(paths, options, shards, overall, stats, error);
+    double end = omp_get_wtime();
+    if (!ok) {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+    
+    if (verbose) {
+        for (size_t i = 0; i < paths.size(); i++) {
+            cout << paths[i] << ": ";
+            if (shards[i].count > 0) cout << shards[i].max_val; else cout << "(empty)";
+            cout << " (" << shards[i].count << " elements)" << endl;
+        }
+    }
+    double seconds = end - start;
+    cout << "Maximum value: " << overall << endl;
+    cout << stats.files << " files, " << stats.bytes / 1e6 << " MB in " << seconds * 1000 << " ms ("
+         << (seconds > 0 ? stats.bytes / seconds / 1e9 : 0.0) << " GB/s), " << stats.reads << " reads via "
+         << (stats.used_uring ? "io_uring" : "pread") << (stats.registered ? " with registered buffers" : "")
+         << ", " << stats.direct_files << " files with O_DIRECT" << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--shards") {
+        return shards_main(argc, argv);
+    }
+    if (argc > 1) {
+        return benchmark_main(argc, argv);
+    }
+    
+    // Seed for the counter-based generator (random_input.h)
+    uint64_t seed = time(NULL);
     
     cout << "==================================================" << endl;
     cout << "    PARALLEL MAXIMUM ALGORITHM (OpenMP)" << endl;
@@ -176,27 +1565,33 @@ int main() {
     cout << endl;
     
     // Get array size from user
-    int n;
+    long long requested;
     cout << "Ingrese el tamaño del arreglo: ";
-    cin >> n;
+    cin >> requested;
     
-    if (n <= 0) {
+    if (requested <= 0) {
         cout << "Error: El tamaño debe ser mayor que 0" << endl;
         return 1;
     }
+    size_t n = requested;
     
-    // Generate random array
-    vector<int> arr(n);
-    cout << "\nGenerando arreglo aleatorio de " << n << " elementos..." << endl;
-    for (int i = 0; i < n; i++) {
-        arr[i] = rand() % 1000;  // Random values between 0 and 999
-    }
+    // Set number of threads before the input is filled, so its pages are
+    // first touched with the partition the methods use
+    int num_threads = 4;
+    omp_set_num_threads(num_threads);
+    
+    // Generate random array, its pages placed with the threads that read
+    // them (same static_chunk partition as the methods)
+    NumaArray<int> arr;
+    arr.allocate(n, NumaPolicy::Touch);
+    cout << "\nGenerando arreglo aleatorio de " << n << " elementos (semilla " << seed << ")..." << endl;
+    fill_input(arr.data(), n, Distribution::Uniform, seed, 0, 999);  // Random values between 0 and 999
     
     cout << endl;
     
     // Print array only if it's small enough
     if (n <= 20) {
-        print_array(arr, "Input Array A");
+        print_array(arr.data(), n, "Input Array A");
     } else {
         cout << "Input Array A (primeros 20 elementos): [";
         for (int i = 0; i < 20; i++) {
@@ -207,16 +1602,13 @@ int main() {
     }
     cout << endl;
     
-    // Set number of threads
-    int num_threads = 4;
-    omp_set_num_threads(num_threads);
     cout << "Number of OpenMP threads: " << num_threads << endl;
     cout << endl;
     
     // Method 1: OpenMP reduction
     cout << "--- Method 1: OpenMP Reduction Clause ---" << endl;
     double start = omp_get_wtime();
-    int max1 = parallel_max_reduction(arr, n);
+    int max1 = parallel_max_reduction(arr.data(), n);
     double end = omp_get_wtime();
     cout << "Maximum value: " << max1 << endl;
     cout << "Time: " << (end - start) * 1000 << " ms" << endl;
@@ -224,9 +1616,8 @@ int main() {
     
     // Method 2: Tree reduction
     cout << "--- Method 2: Manual Tree Reduction ---" << endl;
-    vector<int> arr2 = arr;
     start = omp_get_wtime();
-    int max2 = parallel_max_tree_reduction(arr2, n);
+    int max2 = parallel_max_tree_reduction(arr.data(), n);
     end = omp_get_wtime();
     cout << "Maximum value: " << max2 << endl;
     cout << "Time: " << (end - start) * 1000 << " ms" << endl;
@@ -235,7 +1626,7 @@ int main() {
     // Method 3: Parallel sections
     cout << "--- Method 3: Parallel Sections ---" << endl;
     start = omp_get_wtime();
-    int max3 = parallel_max_sections(arr, n);
+    int max3 = parallel_max_sections(arr.data(), n);
     end = omp_get_wtime();
     cout << "Maximum value: " << max3 << endl;
     cout << "Time: " << (end - start) * 1000 << " ms" << endl;
@@ -243,29 +1634,326 @@ int main() {
     
     // Method 4: Explicit barriers (shows synchronization steps)
     cout << "--- Method 4: Explicit Barriers (Debug Mode) ---" << endl;
-    vector<int> arr4 = arr;
     start = omp_get_wtime();
-    int max4 = parallel_max_explicit_barriers(arr4, n);
+    int max4 = parallel_max_explicit_barriers(arr.data(), n);
     end = omp_get_wtime();
     cout << "Maximum value: " << max4 << endl;
     cout << "Time: " << (end - start) * 1000 << " ms" << endl;
     cout << endl;
     
+    // Method 5: SIMD kernels (runtime dispatch)
+    cout << "--- Method 5: SIMD Kernel (" << simd_level_name(simd_level) << ") ---" << endl;
+    start = omp_get_wtime();
+    int max5 = parallel_max_simd(arr.data(), n);
+    end = omp_get_wtime();
+    cout << "Maximum value: " << max5 << endl;
+    cout << "Time: " << (end - start) * 1000 << " ms" << endl;
+    cout << endl;
+    
+    // Argmax / argmin: every path, at 1, 3 and num_threads threads, must
+    // return the first occurrence (values 0..999 repeat, so ties are common)
+    cout << "--- Argmax / Argmin (value, index) ---" << endl;
+    ValueIndex<int> argmax_seq = sequential_argmax(arr.data(), n);
+    ValueIndex<int> argmin_seq = sequential_argmin(arr.data(), n);
+    bool arg_correct = true;
+    for (auto method : {parallel_argmax_reduction, parallel_argmax_tree, parallel_argmax_sections, parallel_argmax_simd}) {
+        arg_correct = matches_reference([&]() { return method(arr.data(), n); }, [&]() { return argmax_seq; }) && arg_correct;
+    }
+    for (auto method : {parallel_argmin_reduction, parallel_argmin_tree, parallel_argmin_sections, parallel_argmin_simd}) {
+        arg_correct = matches_reference([&]() { return method(arr.data(), n); }, [&]() { return argmin_seq; }) && arg_correct;
+    }
+    start = omp_get_wtime();
+    ValueIndex<int> argmax_simd = parallel_argmax_simd(arr.data(), n);
+    end = omp_get_wtime();
+    cout << "Argmax: " << argmax_simd.value << " at index " << argmax_simd.index << " (SIMD, "
+         << (end - start) * 1000 << " ms)" << endl;
+    start = omp_get_wtime();
+    ValueIndex<int> argmin_simd = parallel_argmin_simd(arr.data(), n);
+    end = omp_get_wtime();
+    cout << "Argmin: " << argmin_simd.value << " at index " << argmin_simd.index << " (SIMD, "
+         << (end - start) * 1000 << " ms)" << endl;
+    cout << endl;
+    
+    // Top-k against a serial heap, for several k and thread counts
+    cout << "--- Top-k (threshold filter + tree merge) ---" << endl;
+    bool topk_correct = true;
+    for (size_t k : {size_t(1), size_t(10), size_t(1000)}) {
+        topk_correct = matches_reference([&]() { return parallel_top_k(arr.data(), n, k); },
+                                         [&]() { return sequential_top_k(arr.data(), n, k); }) && topk_correct;
+    }
+    start = omp_get_wtime();
+    vector<ValueIndex<int>> top10 = parallel_top_k(arr.data(), n, 10);
+    end = omp_get_wtime();
+    cout << "Top " << top10.size() << ":";
+    for (const ValueIndex<int>& e : top10) cout << " " << e.value << "@" << e.index;
+    cout << endl << "Time: " << (end - start) * 1000 << " ms" << endl;
+    cout << endl;
+    
+    // Sliding-window maximum against a monotonic deque, for several window
+    // sizes (including one and the whole array) and thread counts
+    cout << "--- Sliding-Window Maximum (van Herk / Gil-Werman) ---" << endl;
+    bool sliding_correct = true;
+    for (size_t w : {size_t(1), size_t(8), size_t(100), size_t(100000), n}) {
+        if (w > n) continue;
+        sliding_correct = matches_reference([&]() { return parallel_sliding_max(arr.data(), n, w); },
+                                            [&]() { return sequential_sliding_max(arr.data(), n, w); }) && sliding_correct;
+    }
+    start = omp_get_wtime();
+    vector<int> windows = parallel_sliding_max(arr.data(), n, min(n, size_t(1000)));
+    end = omp_get_wtime();
+    cout << "Window " << min(n, size_t(1000)) << ": " << windows.size() << " maxima, first "
+         << windows.front() << ", last " << windows.back() << endl;
+    cout << "Time: " << (end - start) * 1000 << " ms" << endl;
+    cout << endl;
+    
+    // Range-max index against direct reductions: every range for small n,
+    // random ranges otherwise, and a parallel batch against single queries
+    cout << "--- Range-Max Index (block-decomposed sparse table) ---" << endl;
+    vector<RangeQuery> range_queries;
+    if (n <= 64) {
+        for (size_t l = 0; l < n; l++) {
+            for (size_t r = l + 1; r <= n; r++) range_queries.push_back({l, r});
+        }
+    } else {
+        for (size_t q = 0; q < 1000; q++) {
+            size_t l = bounded_random(counter_random(seed, 2 * q), n);
+            size_t len = 1 + bounded_random(counter_random(seed, 2 * q + 1), q % 2 ? n - l : min(n - l, size_t(100)));
+            range_queries.push_back({l, l + len});
+        }
+    }
+    bool range_correct = matches_reference(
+        [&]() {
+            RangeMaxIndex index(arr.data(), n);
+            return make_tuple(index.query_batch(range_queries), index.query(0, n), index.query(n, n));
+        },
+        [&]() {
+            vector<int> expected;
+            for (const RangeQuery& q : range_queries) {
+                expected.push_back(sequential_max(arr.data() + q.begin, q.end - q.begin));
+            }
+            return make_tuple(expected, max5, INT_MIN);
+        });
+    start = omp_get_wtime();
+    RangeMaxIndex range_index(arr.data(), n);
+    double built = omp_get_wtime();
+    vector<int> range_results = range_index.query_batch(range_queries);
+    end = omp_get_wtime();
+    cout << "Max of [0, " << n / 2 + 1 << "): " << range_index.query(0, n / 2 + 1) << endl;
+    cout << "Build: " << (built - start) * 1000 << " ms, " << range_results.size() << " queries: "
+         << (end - built) * 1000 << " ms" << endl;
+    cout << endl;
+    
+    // Segmented max and sum over random groups (some empty), as CSR
+    // offsets and as head flags, against a serial loop per segment
+    cout << "--- Segmented Reductions (CSR offsets / head flags) ---" << endl;
+    bool segmented_correct = true;
+    for (size_t mean_length : {size_t(1), size_t(32), n}) {
+        vector<size_t> offsets = random_segment_offsets(n, mean_length, seed + mean_length);
+        size_t num_segments = offsets.size() - 1;
+        vector<int> expected_max = sequential_segmented_reduce(arr.data(), offsets.data(), num_segments, MaxOp<int>());
+        vector<int64_t> expected_sum = sequential_segmented_reduce(arr.data(), offsets.data(), num_segments, SumOp<int64_t>());
+        
+        // The flag form cannot express empty segments
+        vector<uint8_t> flags(n);
+        segment_flags_from_offsets(offsets.data(), num_segments, flags.data());
+        vector<int> expected_flag_max;
+        vector<int64_t> expected_flag_sum;
+        for (size_t s = 0; s < num_segments; s++) {
+            if (offsets[s] == offsets[s + 1]) continue;
+            expected_flag_max.push_back(expected_max[s]);
+            expected_flag_sum.push_back(expected_sum[s]);
+        }
+        
+        segmented_correct = matches_reference(
+            [&]() {
+                return make_tuple(parallel_segmented_max(arr.data(), offsets.data(), num_segments),
+                                  parallel_segmented_sum(arr.data(), offsets.data(), num_segments),
+                                  parallel_segmented_max(arr.data(), flags.data(), n),
+                                  parallel_segmented_sum(arr.data(), flags.data(), n));
+            },
+            [&]() { return make_tuple(expected_max, expected_sum, expected_flag_max, expected_flag_sum); }) && segmented_correct;
+        
+        // The engine on 64-bit elements, where the chunk kernels and the
+        // carries work on size_t
+        vector<size_t> wide(arr.begin(), arr.end());
+        segmented_correct = matches_reference(
+            [&]() {
+                vector<size_t> max_out(num_segments), sum_out(num_segments);
+                parallel_segmented_reduce(wide.data(), offsets.data(), num_segments, MaxOp<size_t>(), max_out.data());
+                parallel_segmented_reduce(wide.data(), offsets.data(), num_segments, SumOp<size_t>(), sum_out.data());
+                return make_pair(max_out, sum_out);
+            },
+            [&]() {
+                return make_pair(sequential_segmented_reduce(wide.data(), offsets.data(), num_segments, MaxOp<size_t>()),
+                                 sequential_segmented_reduce(wide.data(), offsets.data(), num_segments, SumOp<size_t>()));
+            }) && segmented_correct;
+    }
+    vector<size_t> groups = random_segment_offsets(n, 32, seed);
+    start = omp_get_wtime();
+    vector<int> group_max = parallel_segmented_max(arr.data(), groups.data(), groups.size() - 1);
+    end = omp_get_wtime();
+    cout << group_max.size() << " segments (mean length 32), max of the first: " << group_max.front() << endl;
+    cout << "Time: " << (end - start) * 1000 << " ms" << endl;
+    cout << endl;
+    
+    // NUMA-placed copy of the input, under every placement policy
+    cout << "--- NUMA-Aware Array + Hierarchical Combine (" << numa_node_count() << " node(s)) ---" << endl;
+    bool numa_correct = true;
+    for (NumaPolicy policy : {NumaPolicy::Off, NumaPolicy::Touch, NumaPolicy::Bind}) {
+        NumaArray<int> placed;
+        placed.allocate(n, policy);
+        #pragma omp parallel
+        {
+            size_t chunk_start, chunk_end;
+            static_chunk(n, omp_get_thread_num(), omp_get_num_threads(), chunk_start, chunk_end);
+            copy(arr.begin() + chunk_start, arr.begin() + chunk_end, placed.begin() + chunk_start);
+        }
+        start = omp_get_wtime();
+        int max_numa = parallel_max_numa(placed.data(), n);
+        end = omp_get_wtime();
+        numa_correct = numa_correct && max_numa == max1 && parallel_max_sections(placed.data(), n) == max1;
+        cout << numa_policy_name(policy) << (placed.bound() ? " (bound)" : "") << ": maximum " << max_numa
+             << ", time: " << (end - start) * 1000 << " ms" << endl;
+    }
+    cout << endl;
+    
+    // Generic reduction engine with built-in and user-defined monoids
+    cout << "--- Generic Reduction Engine (MaxOp<int>) ---" << endl;
+    start = omp_get_wtime();
+    int max6 = parallel_reduce(arr.data(), n, MaxOp<int>());
+    end = omp_get_wtime();
+    cout << "Maximum value: " << max6 << endl;
+    cout << "Time: " << (end - start) * 1000 << " ms" << endl;
+    
+    // Same data as other column types, and a custom struct monoid
+    vector<short> arr16(arr.begin(), arr.end());
+    vector<long long> arr64(arr.begin(), arr.end());
+    vector<double> arr_d(arr.begin(), arr.end());
+    vector<MinMax> ranges(n);
+    for (size_t i = 0; i < n; i++) ranges[i] = {arr[i], arr[i]};
+    
+    short max16 = parallel_reduce(arr16, MaxOp<short>());
+    long long sum64 = parallel_reduce(arr64, SumOp<long long>());
+    double min_d = parallel_reduce(arr_d, MinOp<double>());
+    MinMax range = parallel_reduce(ranges, MinMaxOp());
+    cout << "int16 max: " << max16 << ", int64 sum: " << sum64 << ", double min: " << min_d << endl;
+    cout << "MinMax (custom monoid): [" << range.min_val << ", " << range.max_val << "]" << endl;
+    cout << endl;
+    
+    // Sharded files through the io_uring reader, and again through pread;
+    // small blocks so every shard takes several reads
+    cout << "--- Sharded Files (io_uring Reader) ---" << endl;
+    namespace fs = std::filesystem;
+    const size_t NUM_SHARDS = 4;
+    vector<string> shard_paths;
+    vector<int> shard_expected(NUM_SHARDS, INT_MIN);
+    error_code fs_error;
+    fs::path shard_dir = fs::temp_directory_path(fs_error) / ("parallel_max_shards_" + to_string(time(NULL)));
+    fs::create_directories(shard_dir, fs_error);
+    size_t per_shard = (n + NUM_SHARDS - 1) / NUM_SHARDS;
+    for (size_t s = 0; s < NUM_SHARDS; s++) {
+        size_t begin = min(s * per_shard, n);
+        size_t count = min(begin + per_shard, n) - begin;
+        shard_paths.push_back((shard_dir / ("shard" + to_string(s) + ".bin")).string());
+        ofstream file(shard_paths.back(), ios::binary);
+        if (s == NUM_SHARDS - 1) {
+            // Last shard in the headered format
+            ArrayFileHeader header;
+            memcpy(header.magic, ARRAY_FILE_MAGIC, 4);
+            header.element_size = sizeof(int);
+            header.count = count;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        file.write(reinterpret_cast<const char*>(arr.data() + begin), count * sizeof(int));
+        if (count > 0) shard_expected[s] = sequential_max(arr.data() + begin, count);
+    }
+    
+    bool shards_correct = true;
+    for (bool use_uring : {true, false}) {
+        ShardReadOptions options;
+        options.block_size = 4096;
+        options.queue_depth = 8;
+        options.use_uring = use_uring;
+        vector<ShardMax> shard_max;
+        int max_shards = 0;
+        ShardReadStats stats;
+        string shard_error;
+        start = omp_get_wtime();
+        bool ok = parallel_max_shards(shard_paths, options, shard_max, max_shards, stats, shard_error);
+        end = omp_get_wtime();
+        if (!ok) {
+            cout << "Error: " << shard_error << endl;
+            shards_correct = false;
+            continue;
+        }
+        for (size_t s = 0; s < NUM_SHARDS; s++) {
+            ok = ok && shard_max[s].max_val == shard_expected[s];
+        }
+        shards_correct = shards_correct && ok && max_shards == max1;
+        cout << (stats.used_uring ? "io_uring" : "pread") << ": maximum " << max_shards << ", " << stats.reads
+             << " reads, time: " << (end - start) * 1000 << " ms" << endl;
+    }
+    fs::remove_all(shard_dir, fs_error);
+    cout << endl;
+    
     // Sequential for comparison
     cout << "--- Sequential Maximum (for comparison) ---" << endl;
     start = omp_get_wtime();
-    int max_seq = sequential_max(arr, n);
+    int max_seq = sequential_max(arr.data(), n);
     end = omp_get_wtime();
     cout << "Maximum value: " << max_seq << endl;
     cout << "Time: " << (end - start) * 1000 << " ms" << endl;
     cout << endl;
     
+    // Counter-based generator: same array for 1 and num_threads threads,
+    // and the shape each distribution promises
+    cout << "--- Input Generator (all distributions) ---" << endl;
+    bool generator_correct = true;
+    for (Distribution dist : {Distribution::Uniform, Distribution::Sorted, Distribution::Reverse,
+                              Distribution::Equal, Distribution::Zipf, Distribution::Adversarial}) {
+        vector<int> serial(n), parallel(n);
+        omp_set_num_threads(1);
+        fill_input(serial.data(), n, dist, seed, 0, 999);
+        omp_set_num_threads(num_threads);
+        start = omp_get_wtime();
+        fill_input(parallel.data(), n, dist, seed, 0, 999);
+        end = omp_get_wtime();
+        
+        bool ok = (serial == parallel);
+        int top = sequential_max(parallel.data(), n);
+        for (size_t i = 0; i < n; i++) {
+            ok = ok && parallel[i] >= 0 && parallel[i] <= 999;
+            if (i == 0) continue;
+            if (dist == Distribution::Sorted) ok = ok && parallel[i - 1] <= parallel[i];
+            if (dist == Distribution::Reverse) ok = ok && parallel[i - 1] >= parallel[i];
+            if (dist == Distribution::Equal) ok = ok && parallel[i] == parallel[0];
+        }
+        if (dist == Distribution::Adversarial) {
+            ok = ok && top == 999 && count(parallel.begin(), parallel.end(), 999) == 1 && parallel[n - 1] == 999;
+        }
+        ok = ok && parallel_max_simd(parallel.data(), n) == top && parallel_max_reduction(parallel.data(), n) == top;
+        generator_correct = generator_correct && ok;
+        cout << distribution_name(dist) << ": max " << top << ", " << (end - start) * 1000 << " ms"
+             << (ok ? "" : " (MISMATCH)") << endl;
+    }
+    cout << endl;
+    
     // Verification
     cout << "==================================================" << endl;
     cout << "VERIFICATION" << endl;
     cout << "==================================================" << endl;
     cout << "All methods found maximum: " << max1 << endl;
-    bool all_correct = (max1 == max2 && max2 == max3 && max3 == max4 && max4 == max_seq);
+    long long sum_seq = 0;
+    int min_seq = INT_MAX;
+    for (size_t i = 0; i < n; i++) {
+        sum_seq += arr[i];
+        min_seq = min(min_seq, arr[i]);
+    }
+    bool generic_correct = (max6 == max_seq && max16 == max_seq && sum64 == sum_seq && min_d == min_seq &&
+                            range.min_val == min_seq && range.max_val == max_seq);
+    bool all_correct = (max1 == max2 && max2 == max3 && max3 == max4 && max4 == max5 && max5 == max_seq &&
+                        generic_correct && shards_correct && generator_correct && numa_correct && arg_correct && topk_correct &&
+                        sliding_correct && segmented_correct && range_correct);
     cout << "Status: " << (all_correct ? "PASSED ✓" : "FAILED ✗") << endl;
     
     return 0;
@@ -0,0 +1,191 @@
+/**
+ * Hardware performance counters per method (Linux perf_event_open)
+ *
+ * Opens cycles, instructions, LLC misses, dTLB misses and branch misses
+ * on every thread of the current OpenMP team, so counts include the
+ * work of all threads. Counters that the kernel or the CPU does not
+ * provide (no PMU in a VM, perf_event_paranoid too strict) are reported
+ * as unavailable instead of failing the run.
+ *
+ * Counting relies on the OpenMP runtime reusing the same threads for
+ * consecutive parallel regions of the same size, which libgomp and the
+ * LLVM runtime both do.
+ */
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <omp.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum PerfEvent {
+    PERF_CYCLES = 0,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+inline const char* perf_event_name(int event) {
+    static const char* names[PERF_EVENT_COUNT] = {
+        "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"
+    };
+    return names[event];
+}
+
+/**
+ * Counts summed over all threads; valid[e] is false when event e could
+ * not be opened on at least one thread
+ */
+struct PerfCounts {
+    double value[PERF_EVENT_COUNT] = {};
+    bool valid[PERF_EVENT_COUNT] = {};
+};
+
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters() { close_all(); }
+
+    /**
+     * Opens one counter per event on each thread of a team of
+     * num_threads threads. Returns false if no counter could be opened.
+     */
+    bool open(int num_threads) {
+        close_all();
+#ifdef __linux__
+        fds_.assign(num_threads, std::vector<int>(PERF_EVENT_COUNT, -1));
+
+        #pragma omp parallel num_threads(num_threads)
+        {
+            int tid = omp_get_thread_num();
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                perf_event_attr attr = make_attr(e);
+                // pid = 0, cpu = -1: this thread, on whichever CPU it runs
+                fds_[tid][e] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+            }
+        }
+
+        for (const std::vector<int>& thread_fds : fds_) {
+            for (int fd : thread_fds) {
+                if (fd >= 0) return true;
+            }
+        }
+#else
+        (void)num_threads;
+#endif
+        return false;
+    }
+
+    /** Zeroes all counters (they stay disabled) */
+    void reset() { for_each_fd(reset_request()); }
+
+    /** Counts only between resume() and pause(), so verification can be excluded */
+    void resume() { for_each_fd(enable_request()); }
+    void pause() { for_each_fd(disable_request()); }
+
+    /**
+     * Reads every counter, scales it for multiplexing and sums it over
+     * the threads
+     */
+    PerfCounts read() const {
+        PerfCounts counts;
+        for (int e = 0; e < PERF_EVENT_COUNT; e++) counts.valid[e] = !fds_.empty();
+
+#ifdef __linux__
+        for (const std::vector<int>& thread_fds : fds_) {
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                uint64_t data[3];  // value, time enabled, time running
+                if (thread_fds[e] < 0 || ::read(thread_fds[e], data, sizeof(data)) != (ssize_t)sizeof(data)) {
+                    counts.valid[e] = false;
+                    continue;
+                }
+                double scale = (data[2] > 0) ? (double)data[1] / data[2] : 0.0;
+                counts.value[e] += data[0] * scale;
+            }
+        }
+#endif
+        return counts;
+    }
+
+private:
+    std::vector<std::vector<int>> fds_;
+
+#ifdef __linux__
+    static perf_event_attr make_attr(int event) {
+        perf_event_attr attr = {};
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        switch (event) {
+            case PERF_CYCLES:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PERF_INSTRUCTIONS:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PERF_LLC_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case PERF_DTLB_MISSES:
+                attr.type = PERF_TYPE_HW_CACHE;
+                attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            default:
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+        }
+        return attr;
+    }
+
+    static unsigned long reset_request()   { return PERF_EVENT_IOC_RESET; }
+    static unsigned long enable_request()  { return PERF_EVENT_IOC_ENABLE; }
+    static unsigned long disable_request() { return PERF_EVENT_IOC_DISABLE; }
+
+    void for_each_fd(unsigned long request) {
+        for (const std::vector<int>& thread_fds : fds_) {
+            for (int fd : thread_fds) {
+                if (fd >= 0) ioctl(fd, request, 0);
+            }
+        }
+    }
+
+    void close_all() {
+        for (const std::vector<int>& thread_fds : fds_) {
+            for (int fd : thread_fds) {
+                if (fd >= 0) close(fd);
+            }
+        }
+        fds_.clear();
+    }
+#else
+    static unsigned long reset_request()   { return 0; }
+    static unsigned long enable_request()  { return 0; }
+    static unsigned long disable_request() { return 0; }
+    void for_each_fd(unsigned long) {}
+    void close_all() { fds_.clear(); }
+#endif
+};
+
+#endif // PERF_COUNTERS_H
@@ -4,7 +4,7 @@
  * This implementation computes the prefix sum using the Blelloch algorithm
  * with two phases: Upsweep (Reduce) and Downsweep
  * 
- * Compilation: g++ -fopenmp prefix_sum_scan.cpp -o prefix_sum_scan
+ * Compilation: g++ -std=c++20 -O3 -fopenmp prefix_sum_scan.cpp -o prefix_sum_scan
  * Execution: ./prefix_sum_scan
  */
 
@@ -12,221 +12,1460 @@
 #include <vector>
 #include <omp.h>
 #include <cmath>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
 #include <algorithm>
 #include <cstdlib>
 #include <ctime>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <span>
+
+#include "benchmark.h"
+#include "cpu_features.h"
+#include "mapped_array.h"
+#include "monoids.h"
+#include "numa_array.h"
+#include "random_input.h"
+#include "segments.h"
+#include "trace.h"
 
 using namespace std;
 
+// Debug printing of intermediate tree states (disabled in benchmark mode)
+bool debug_output = true;
+
+/**
+ * Per-thread scratch buffer reused across calls, so the span and in-place
+ * scan APIs stop touching the heap once it has grown to the working size.
+ * Slot distinguishes independent buffers of the same type in one call.
+ */
+template <typename T, int Slot = 0>
+T* scan_scratch(size_t count) {
+    thread_local unique_ptr<T[]> buffer;
+    thread_local size_t capacity = 0;
+    if (capacity < count) {
+        buffer.reset(new T[count]);
+        capacity = count;
+    }
+    return buffer.get();
+}
+
 /**
  * Method 1: Blelloch Scan - Work-efficient parallel prefix sum
  * Uses two-phase approach: Upsweep (Reduce) + Downsweep
  * 
+ * Works on any N without padding: the partial last subtree of every
+ * level keeps its value at index n-1, so memory and work track the
+ * real input size instead of the next power of two.
+ * 
  * Time Complexity: O(N) work, O(log N) span
- * Synchronization: 2*log2(N) barriers
+ * Synchronization: 2*ceil(log2(N)) barriers
  * 
- * Computes INCLUSIVE scan
+ * Computes INCLUSIVE scan into out (out may be the same memory as arr)
  */
-vector<int> parallel_prefix_sum_blelloch(vector<int> arr) {
-    int n = arr.size();
+void parallel_prefix_sum_blelloch(span<const int> arr, span<int> out) {
+    size_t n = arr.size();
     
-    // Ensure n is power of 2 (pad if necessary)
-    int original_n = n;
-    int log_n = (int)ceil(log2(n));
-    n = 1 << log_n;  // Next power of 2
+    if (n == 0) return;
     
-    vector<int> temp(n, 0);
-    for (int i = 0; i < original_n; i++) {
-        temp[i] = arr[i];
-    }
+    // Number of tree levels: ceil(log2(n))
+    int log_n = 0;
+    while ((size_t(1) << log_n) < n) log_n++;
     
-    cout << "Number of elements (padded): " << n << endl;
-    cout << "Number of levels: " << log_n << endl;
-    cout << "Synchronization steps: " << (2 * log_n) << " (" << log_n << " upsweep + " << log_n << " downsweep)" << endl;
-    cout << endl;
+    // The tree is built directly in the output buffer
+    int* temp = out.data();
+    bool copy_in = (arr.data() != temp);
     
-    // =================================================================
-    // PHASE 1: UPSWEEP (Reduce) - Build reduction tree
-    // =================================================================
-    cout << "--- UPSWEEP PHASE ---" << endl;
-    cout << "Initial: ";
-    for (int i = 0; i < min(n, 16); i++) cout << temp[i] << " ";
-    cout << endl;
+    if (debug_output) {
+        cout << "Number of elements: " << n << endl;
+        cout << "Number of levels: " << log_n << endl;
+        cout << "Synchronization steps: " << (2 * log_n) << " (" << log_n << " upsweep + " << log_n << " downsweep)" << endl;
+        cout << endl;
+    }
+    
+    int total_sum = 0;
     
-    for (int d = 0; d < log_n; d++) {
-        int stride = 1 << (d + 1);  // 2^(d+1)
-        int offset = (1 << d) - 1;  // 2^d - 1
+    // One persistent team runs both phases; levels are separated by
+    // in-team barriers instead of a fork/join per level. Each phase is
+    // traced per thread without the barrier wait (see trace.h).
+    #pragma omp parallel
+    {
+        if (copy_in) {
+            {
+                TRACE_SCOPE("copy-in");
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i++) {
+                    temp[i] = arr[i];
+                }
+            }
+            #pragma omp barrier
+        }
+        
+        // =============================================================
+        // PHASE 1: UPSWEEP (Reduce) - Build reduction tree
+        // =============================================================
+        if (debug_output) {
+            #pragma omp single
+            {
+                cout << "--- UPSWEEP PHASE ---" << endl;
+                cout << "Initial: ";
+                for (size_t i = 0; i < min<size_t>(n, 16); i++) cout << temp[i] << " ";
+                cout << endl;
+            }
+        }
+        
+        for (int d = 0; d < log_n; d++) {
+            size_t stride = size_t(1) << (d + 1);  // 2^(d+1)
+            size_t offset = (size_t(1) << d) - 1;  // 2^d - 1
+            
+            {
+                TRACE_SCOPE_ARG("upsweep", d);
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i += stride) {
+                    // A partial last subtree stores its root at n-1
+                    size_t left = i + offset;
+                    size_t right = min(i + stride - 1, n - 1);
+                    if (left < right) {
+                        temp[right] += temp[left];
+                    }
+                }
+            }
+            #pragma omp barrier
+            
+            if (debug_output) {
+                #pragma omp single
+                {
+                    cout << "Level " << d << " (stride=" << stride << "): ";
+                    for (size_t i = 0; i < min<size_t>(n, 16); i++) cout << temp[i] << " ";
+                    cout << endl;
+                }
+            }
+        }
+        
+        // =============================================================
+        // PHASE 2: DOWNSWEEP - Propagate partial sums down the tree
+        // =============================================================
+        #pragma omp single
+        {
+            // Set root to 0 (for exclusive scan)
+            // For inclusive scan, we'll adjust at the end
+            total_sum = temp[n - 1];
+            temp[n - 1] = 0;
+            
+            if (debug_output) {
+                cout << endl;
+                cout << "--- DOWNSWEEP PHASE ---" << endl;
+                cout << "Set root to 0: ";
+                for (size_t i = 0; i < min<size_t>(n, 16); i++) cout << temp[i] << " ";
+                cout << endl;
+            }
+        }
         
-        #pragma omp parallel for
-        for (int i = 0; i < n; i += stride) {
-            temp[i + stride - 1] += temp[i + offset];
+        for (int d = log_n - 1; d >= 0; d--) {
+            size_t stride = size_t(1) << (d + 1);  // 2^(d+1)
+            size_t offset = (size_t(1) << d) - 1;  // 2^d - 1
+            
+            {
+                TRACE_SCOPE_ARG("downsweep", d);
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i += stride) {
+                    // When the left child already reaches n-1 it shares the
+                    // parent's slot and the (empty) right child has nothing to do
+                    size_t left = i + offset;
+                    size_t right = min(i + stride - 1, n - 1);
+                    if (left < right) {
+                        int t = temp[left];
+                        temp[left] = temp[right];
+                        temp[right] += t;
+                    }
+                }
+            }
+            #pragma omp barrier
+            
+            if (debug_output) {
+                #pragma omp single
+                {
+                    cout << "Level " << (log_n - 1 - d) << " (stride=" << stride << "): ";
+                    for (size_t i = 0; i < min<size_t>(n, 16); i++) cout << temp[i] << " ";
+                    cout << endl;
+                }
+            }
         }
         
+        if (debug_output) {
+            #pragma omp single
+            {
+                cout << endl;
+                cout << "Result (Exclusive): ";
+                for (size_t i = 0; i < min<size_t>(n, 16); i++) cout << temp[i] << " ";
+                cout << endl;
+                cout << "Total sum (root): " << total_sum << endl;
+            }
+        }
+        
+        // Convert exclusive scan to inclusive scan
+        // Inclusive[i] = Exclusive[i+1], Inclusive[n-1] = total
+        // (shifting instead of adding Original[i] keeps this valid in-place)
+        int tid = omp_get_thread_num();
+        int num_threads = omp_get_num_threads();
+        size_t chunk_size = (n + num_threads - 1) / num_threads;
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
+        
+        // Read the first element of the next chunk before its owner shifts it
+        int next = (end < n) ? temp[end] : total_sum;
+        
         #pragma omp barrier
         
-        cout << "Level " << d << " (stride=" << stride << "): ";
-        for (int i = 0; i < min(n, 16); i++) cout << temp[i] << " ";
-        cout << endl;
+        TRACE_SCOPE("exclusive-to-inclusive");
+        if (start < end) {
+            for (size_t i = start; i < end - 1; i++) {
+                temp[i] = temp[i + 1];
+            }
+            temp[end - 1] = next;
+        }
     }
+}
+
+void parallel_prefix_sum_blelloch(span<int> data) {
+    parallel_prefix_sum_blelloch(data, data);
+}
+
+vector<int> parallel_prefix_sum_blelloch(const vector<int>& arr) {
+    vector<int> result(arr.size());
+    parallel_prefix_sum_blelloch(arr, result);
+    return result;
+}
+
+/**
+ * Alternative (not in the demo): Simple Parallel Prefix Sum using OpenMP scan directive
+ * (Available in OpenMP 5.0+)
+ * 
+ * This is simpler but may not be available in all OpenMP implementations
+ */
+void parallel_prefix_sum_omp_scan(span<const int> arr, span<int> out) {
+    size_t n = arr.size();
     
-    cout << endl;
+    if (n == 0) return;
     
-    // =================================================================
-    // PHASE 2: DOWNSWEEP - Propagate partial sums down the tree
-    // =================================================================
-    cout << "--- DOWNSWEEP PHASE ---" << endl;
+    #pragma omp parallel
+    {
+        #pragma omp for
+        for (size_t i = 0; i < n; i++) {
+            out[i] = arr[i];
+        }
+        
+        // Note: OpenMP scan directive might not be available in all versions
+        // This is a simplified version
+        #pragma omp single
+        {
+            for (size_t i = 1; i < n; i++) {
+                out[i] = out[i-1] + out[i];
+            }
+        }
+    }
+}
+
+void parallel_prefix_sum_omp_scan(span<int> data) {
+    parallel_prefix_sum_omp_scan(data, data);
+}
+
+vector<int> parallel_prefix_sum_omp_scan(const vector<int>& arr) {
+    vector<int> result(arr.size());
+    parallel_prefix_sum_omp_scan(arr, result);
+    return result;
+}
+
+/**
+ * SIMD scan kernels for the block-local passes
+ * A scalar scan is one long `sum += x` dependency chain. The vector
+ * kernels scan a whole register with log2(W) shift-and-add steps, then
+ * add the running offset carried from the previous register, so only
+ * one add and one broadcast per W elements stay on the critical path.
+ * The widest ISA is selected once at startup (see cpu_features.h).
+ * 
+ * scan_kernel(in, out, n, carry): out[i] = carry + in[0] + ... + in[i],
+ * returns the last value (carry + sum). in may alias out.
+ * offset_kernel(data, n, offset): data[i] += offset.
+ */
+int scan_kernel_scalar(const int* in, int* out, size_t n, int carry) {
+    for (size_t i = 0; i < n; i++) {
+        carry += in[i];
+        out[i] = carry;
+    }
+    return carry;
+}
+
+void offset_kernel_scalar(int* data, size_t n, int offset) {
+    for (size_t i = 0; i < n; i++) {
+        data[i] += offset;
+    }
+}
+
+#if SIMD_X86
+__attribute__((target("avx2")))
+int scan_kernel_avx2(const int* in, int* out, size_t n, int carry) {
+    __m256i offset = _mm256_set1_epi32(carry);
+    const __m256i last = _mm256_set1_epi32(7);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(in + i));
+        // Scan each 128-bit half, then add the low half's total to the high half
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+        x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+        __m256i half_totals = _mm256_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        x = _mm256_add_epi32(x, _mm256_permute2x128_si256(half_totals, half_totals, 0x08));
+        x = _mm256_add_epi32(x, offset);
+        _mm256_storeu_si256((__m256i*)(out + i), x);
+        offset = _mm256_permutevar8x32_epi32(x, last);
+    }
+    return scan_kernel_scalar(in + i, out + i, n - i, _mm256_cvtsi256_si32(offset));
+}
+
+__attribute__((target("avx2")))
+void offset_kernel_avx2(int* data, size_t n, int offset) {
+    __m256i v = _mm256_set1_epi32(offset);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(data + i));
+        _mm256_storeu_si256((__m256i*)(data + i), _mm256_add_epi32(x, v));
+    }
+    offset_kernel_scalar(data + i, n - i, offset);
+}
+
+__attribute__((target("avx512f")))
+int scan_kernel_avx512(const int* in, int* out, size_t n, int carry) {
+    __m512i offset = _mm512_set1_epi32(carry);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i last = _mm512_set1_epi32(15);
+    for (size_t i = 0; i < n; i += 16) {
+        // Masked tail: missing lanes load as 0, so lane 15 is still the total
+        __mmask16 mask = (n - i >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512i x = _mm512_maskz_loadu_epi32(mask, in + i);
+        // alignr(x, zero, 16 - k) shifts x up by k lanes, filling with 0
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 15));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 14));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 12));
+        x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 8));
+        x = _mm512_add_epi32(x, offset);
+        _mm512_mask_storeu_epi32(out + i, mask, x);
+        offset = _mm512_permutexvar_epi32(last, x);
+    }
+    return _mm_cvtsi128_si32(_mm512_castsi512_si128(offset));
+}
+
+__attribute__((target("avx512f")))
+void offset_kernel_avx512(int* data, size_t n, int offset) {
+    __m512i v = _mm512_set1_epi32(offset);
+    for (size_t i = 0; i < n; i += 16) {
+        __mmask16 mask = (n - i >= 16) ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512i x = _mm512_maskz_loadu_epi32(mask, data + i);
+        _mm512_mask_storeu_epi32(data + i, mask, _mm512_add_epi32(x, v));
+    }
+}
+#endif
+
+using ScanKernel = int (*)(const int*, int*, size_t, int);
+using OffsetKernel = void (*)(int*, size_t, int);
+
+// SSE4.1 has no kernel of its own: 4 lanes barely beat the scalar chain
+ScanKernel select_scan_kernel(SimdLevel level) {
+    switch (level) {
+#if SIMD_X86
+        case SimdLevel::AVX512: return scan_kernel_avx512;
+        case SimdLevel::AVX2:   return scan_kernel_avx2;
+#endif
+        default:                return scan_kernel_scalar;
+    }
+}
+
+OffsetKernel select_offset_kernel(SimdLevel level) {
+    switch (level) {
+#if SIMD_X86
+        case SimdLevel::AVX512: return offset_kernel_avx512;
+        case SimdLevel::AVX2:   return offset_kernel_avx2;
+#endif
+        default:                return offset_kernel_scalar;
+    }
+}
+
+// Selected once at program startup
+const SimdLevel simd_level = detect_simd_level();
+const ScanKernel scan_kernel = select_scan_kernel(simd_level);
+const OffsetKernel offset_kernel = select_offset_kernel(simd_level);
+
+/**
+ * Widening scan kernels: int32 input, int64 running sum
+ * The sign extension happens as each register is loaded, so widening
+ * costs no separate pass. The checked variant stores the low 32 bits
+ * (the wrapped int result) and sets overflow when any running sum
+ * leaves the int range.
+ * 
+ * scan_kernel_wide(in, out, n, carry): out[i] = carry + in[0] + ... + in[i]
+ * scan_kernel_checked(in, out, n, carry, overflow): same, narrowed to int
+ * Both return the last running sum.
+ */
+int64_t scan_kernel_wide_scalar(const int* in, int64_t* out, size_t n, int64_t carry) {
+    for (size_t i = 0; i < n; i++) {
+        carry += in[i];
+        out[i] = carry;
+    }
+    return carry;
+}
+
+int64_t scan_kernel_checked_scalar(const int* in, int* out, size_t n, int64_t carry, bool& overflow) {
+    bool out_of_range = false;
+    for (size_t i = 0; i < n; i++) {
+        carry += in[i];
+        out_of_range |= (carry > INT_MAX) | (carry < INT_MIN);
+        out[i] = (int)carry;
+    }
+    overflow = overflow || out_of_range;
+    return carry;
+}
+
+#if SIMD_X86
+// Inclusive scan of four int64 lanes (two 128-bit halves)
+__attribute__((target("avx2"), always_inline))
+inline __m256i scan_lanes_epi64_avx2(__m256i x) {
+    x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+    __m256i low_total = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 1, 1, 1));
+    return _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_setzero_si256(), low_total, 0xF0));
+}
+
+__attribute__((target("avx2")))
+int64_t scan_kernel_wide_avx2(const int* in, int64_t* out, size_t n, int64_t carry) {
+    __m256i offset = _mm256_set1_epi64x(carry);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(in + i)));
+        x = _mm256_add_epi64(scan_lanes_epi64_avx2(x), offset);
+        _mm256_storeu_si256((__m256i*)(out + i), x);
+        offset = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    carry = _mm_cvtsi128_si64(_mm256_castsi256_si128(offset));
+    return scan_kernel_wide_scalar(in + i, out + i, n - i, carry);
+}
+
+__attribute__((target("avx2")))
+int64_t scan_kernel_checked_avx2(const int* in, int* out, size_t n, int64_t carry, bool& overflow) {
+    __m256i offset = _mm256_set1_epi64x(carry);
+    const __m256i int_min = _mm256_set1_epi64x(INT_MIN);
+    const __m256i int_max = _mm256_set1_epi64x(INT_MAX);
+    const __m256i even_lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    __m256i out_of_range = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)(in + i)));
+        x = _mm256_add_epi64(scan_lanes_epi64_avx2(x), offset);
+        out_of_range = _mm256_or_si256(out_of_range, _mm256_cmpgt_epi64(x, int_max));
+        out_of_range = _mm256_or_si256(out_of_range, _mm256_cmpgt_epi64(int_min, x));
+        // Keep the low 32 bits of every lane
+        __m256i narrowed = _mm256_permutevar8x32_epi32(x, even_lanes);
+        _mm_storeu_si128((__m128i*)(out + i), _mm256_castsi256_si128(narrowed));
+        offset = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    overflow = overflow || !_mm256_testz_si256(out_of_range, out_of_range);
+    carry = _mm_cvtsi128_si64(_mm256_castsi256_si128(offset));
+    return scan_kernel_checked_scalar(in + i, out + i, n - i, carry, overflow);
+}
+
+// Inclusive scan of eight int64 lanes: alignr(x, zero, 8 - k) shifts up by k lanes
+__attribute__((target("avx512f"), always_inline))
+inline __m512i scan_lanes_epi64_avx512(__m512i x) {
+    const __m512i zero = _mm512_setzero_si512();
+    x = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 7));
+    x = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 6));
+    return _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 4));
+}
+
+__attribute__((target("avx512f")))
+int64_t scan_kernel_wide_avx512(const int* in, int64_t* out, size_t n, int64_t carry) {
+    __m512i offset = _mm512_set1_epi64(carry);
+    const __m512i last = _mm512_set1_epi64(7);
+    for (size_t i = 0; i < n; i += 8) {
+        __mmask8 mask = (n - i >= 8) ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m256i narrow = _mm512_castsi512_si256(_mm512_maskz_loadu_epi32(mask, in + i));
+        __m512i x = _mm512_add_epi64(scan_lanes_epi64_avx512(_mm512_cvtepi32_epi64(narrow)), offset);
+        _mm512_mask_storeu_epi64(out + i, mask, x);
+        offset = _mm512_permutexvar_epi64(last, x);
+    }
+    return _mm_cvtsi128_si64(_mm512_castsi512_si128(offset));
+}
+
+__attribute__((target("avx512f")))
+int64_t scan_kernel_checked_avx512(const int* in, int* out, size_t n, int64_t carry, bool& overflow) {
+    __m512i offset = _mm512_set1_epi64(carry);
+    const __m512i last = _mm512_set1_epi64(7);
+    const __m512i int_min = _mm512_set1_epi64(INT_MIN);
+    const __m512i int_max = _mm512_set1_epi64(INT_MAX);
+    __mmask8 out_of_range = 0;
+    for (size_t i = 0; i < n; i += 8) {
+        __mmask8 mask = (n - i >= 8) ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m256i narrow = _mm512_castsi512_si256(_mm512_maskz_loadu_epi32(mask, in + i));
+        __m512i x = _mm512_add_epi64(scan_lanes_epi64_avx512(_mm512_cvtepi32_epi64(narrow)), offset);
+        out_of_range |= _mm512_mask_cmpgt_epi64_mask(mask, x, int_max) | _mm512_mask_cmplt_epi64_mask(mask, x, int_min);
+        _mm512_mask_cvtepi64_storeu_epi32(out + i, mask, x);
+        offset = _mm512_permutexvar_epi64(last, x);
+    }
+    overflow = overflow || out_of_range != 0;
+    return _mm_cvtsi128_si64(_mm512_castsi512_si128(offset));
+}
+#endif
+
+using WideScanKernel = int64_t (*)(const int*, int64_t*, size_t, int64_t);
+using CheckedScanKernel = int64_t (*)(const int*, int*, size_t, int64_t, bool&);
+
+WideScanKernel select_wide_scan_kernel(SimdLevel level) {
+    switch (level) {
+#if SIMD_X86
+        case SimdLevel::AVX512: return scan_kernel_wide_avx512;
+        case SimdLevel::AVX2:   return scan_kernel_wide_avx2;
+#endif
+        default:                return scan_kernel_wide_scalar;
+    }
+}
+
+CheckedScanKernel select_checked_scan_kernel(SimdLevel level) {
+    switch (level) {
+#if SIMD_X86
+        case SimdLevel::AVX512: return scan_kernel_checked_avx512;
+        case SimdLevel::AVX2:   return scan_kernel_checked_avx2;
+#endif
+        default:                return scan_kernel_checked_scalar;
+    }
+}
+
+const WideScanKernel scan_kernel_wide = select_wide_scan_kernel(simd_level);
+const CheckedScanKernel scan_kernel_checked = select_checked_scan_kernel(simd_level);
+
+/**
+ * Method 2: Parallel Prefix Sum using divide and conquer
+ * Good for understanding the parallel decomposition
+ * Both per-thread passes run the SIMD scan/offset kernels above.
+ */
+void parallel_prefix_sum_recursive(span<const int> arr, span<int> out) {
+    size_t n = arr.size();
     
-    // Set root to 0 (for exclusive scan)
-    // For inclusive scan, we'll adjust at the end
-    int total_sum = temp[n - 1];
-    temp[n - 1] = 0;
+    if (n == 0) return;
     
-    cout << "Set root to 0: ";
-    for (int i = 0; i < min(n, 16); i++) cout << temp[i] << " ";
-    cout << endl;
+    int num_threads = omp_get_max_threads();
+    int* block_sums = scan_scratch<int, 0>(num_threads);
+    int* block_prefix = scan_scratch<int, 1>(num_threads);
+    fill(block_sums, block_sums + num_threads, 0);
     
-    for (int d = log_n - 1; d >= 0; d--) {
-        int stride = 1 << (d + 1);  // 2^(d+1)
-        int offset = (1 << d) - 1;  // 2^d - 1
+    // Phase 1: Compute prefix sum in each block
+    #pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        size_t chunk_size = (n + num_threads - 1) / num_threads;
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
         
-        #pragma omp parallel for
-        for (int i = 0; i < n; i += stride) {
-            int t = temp[i + offset];
-            temp[i + offset] = temp[i + stride - 1];
-            temp[i + stride - 1] += t;
+        if (start < end) {
+            TRACE_SCOPE("block-scan");
+            block_sums[tid] = scan_kernel(&arr[start], &out[start], end - start, 0);
         }
+    }
+    
+    // Phase 2: Compute prefix sum of block sums (sequential for simplicity)
+    {
+        TRACE_SCOPE("block-prefix");
+        block_prefix[0] = 0;
+        for (int i = 1; i < num_threads; i++) {
+            block_prefix[i] = block_prefix[i-1] + block_sums[i-1];
+        }
+    }
+    
+    // Phase 3: Add block prefix to each element
+    #pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        size_t chunk_size = (n + num_threads - 1) / num_threads;
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
         
+        // Block 0 has no predecessors
+        if (tid > 0 && start < end) {
+            TRACE_SCOPE("fix-up");
+            offset_kernel(&out[start], end - start, block_prefix[tid]);
+        }
+    }
+}
+
+void parallel_prefix_sum_recursive(span<int> data) {
+    parallel_prefix_sum_recursive(data, data);
+}
+
+vector<int> parallel_prefix_sum_recursive(const vector<int>& arr) {
+    vector<int> result(arr.size());
+    parallel_prefix_sum_recursive(arr, result);
+    return result;
+}
+
+/**
+ * Method 3: Single-pass Prefix Sum with decoupled look-back
+ * Tiles are claimed in order through an atomic counter. Each tile is
+ * scanned locally, publishes its aggregate, then walks back over its
+ * predecessors until it finds one that already published an inclusive
+ * prefix. The fix-up runs while the tile is still in cache, so the
+ * input is read once from memory and the output written once.
+ * 
+ * Time Complexity: O(N) work, O(N/P + look-back) span
+ * Synchronization: none global; per-tile release/acquire flags
+ */
+const size_t LOOKBACK_TILE = 4096;  // 16 KB of ints, stays in L1/L2
+
+enum TileFlag { TILE_INVALID = 0, TILE_AGGREGATE = 1, TILE_PREFIX = 2 };
+
+struct alignas(64) TileStatus {
+    atomic<int> flag;
+    int aggregate;         // Sum of this tile only (valid once flag >= AGGREGATE)
+    int inclusive_prefix;  // Sum of all tiles up to this one (valid once flag == PREFIX)
+};
+
+void parallel_prefix_sum_lookback(span<const int> arr, span<int> out) {
+    size_t n = arr.size();
+    
+    if (n == 0) return;
+    
+    size_t num_tiles = (n + LOOKBACK_TILE - 1) / LOOKBACK_TILE;
+    TileStatus* status = scan_scratch<TileStatus>(num_tiles);
+    for (size_t t = 0; t < num_tiles; t++) {
+        status[t].flag.store(TILE_INVALID, memory_order_relaxed);
+    }
+    atomic<size_t> next_tile(0);
+    
+    #pragma omp parallel
+    {
+        while (true) {
+            // Tiles are handed out in increasing order, so every predecessor
+            // is already owned by a running thread and look-back cannot deadlock
+            size_t tile = next_tile.fetch_add(1, memory_order_relaxed);
+            if (tile >= num_tiles) break;
+            
+            size_t start = tile * LOOKBACK_TILE;
+            size_t end = min(start + LOOKBACK_TILE, n);
+            
+            // Local scan of the tile
+            int local_sum;
+            {
+                TRACE_SCOPE_ARG("tile-scan", tile);
+                local_sum = scan_kernel(&arr[start], &out[start], end - start, 0);
+            }
+            
+            if (tile == 0) {
+                status[0].inclusive_prefix = local_sum;
+                status[0].flag.store(TILE_PREFIX, memory_order_release);
+                continue;
+            }
+            
+            status[tile].aggregate = local_sum;
+            status[tile].flag.store(TILE_AGGREGATE, memory_order_release);
+            
+            // Decoupled look-back over the predecessors
+            TRACE_SCOPE_ARG("look-back+fix-up", tile);
+            int exclusive_prefix = 0;
+            size_t pred = tile - 1;
+            while (true) {
+                int flag = status[pred].flag.load(memory_order_acquire);
+                if (flag == TILE_PREFIX) {
+                    exclusive_prefix += status[pred].inclusive_prefix;
+                    break;
+                }
+                if (flag == TILE_AGGREGATE) {
+                    exclusive_prefix += status[pred].aggregate;
+                    pred--;
+                } else {
+                    this_thread::yield();
+                }
+            }
+            
+            status[tile].inclusive_prefix = exclusive_prefix + local_sum;
+            status[tile].flag.store(TILE_PREFIX, memory_order_release);
+            
+            // Fix-up while the tile is still cache-resident
+            offset_kernel(&out[start], end - start, exclusive_prefix);
+        }
+    }
+}
+
+void parallel_prefix_sum_lookback(span<int> data) {
+    parallel_prefix_sum_lookback(data, data);
+}
+
+vector<int> parallel_prefix_sum_lookback(const vector<int>& arr) {
+    vector<int> result(arr.size());
+    parallel_prefix_sum_lookback(arr, result);
+    return result;
+}
+
+/**
+ * Method 4: Cache-blocked hybrid Blelloch scan
+ * Each thread reduces L1/L2-sized tiles locally, the Blelloch tree runs
+ * only over the tile aggregates, and the top levels of that tree are
+ * done by one thread once they hold fewer nodes than threads. The
+ * strided tree passes therefore never walk the full array, and power-
+ * of-two strides no longer alias into the same cache sets.
+ * 
+ * Time Complexity: O(N) work, O(N/P + log(N/TILE)) span
+ * Synchronization: 2*ceil(log2(N/TILE)) barriers at most
+ */
+const size_t BLOCKED_TILE = 8192;  // 32 KB of ints per tile
+
+void parallel_prefix_sum_blelloch_blocked(span<const int> arr, span<int> out) {
+    size_t n = arr.size();
+    
+    if (n == 0) return;
+    
+    size_t num_tiles = (n + BLOCKED_TILE - 1) / BLOCKED_TILE;
+    int* tile_sums = scan_scratch<int, 2>(num_tiles);
+    
+    int log_t = 0;
+    while ((size_t(1) << log_t) < num_tiles) log_t++;
+    
+    #pragma omp parallel
+    {
+        int num_threads = omp_get_num_threads();
+        
+        // Phase 1: reduce each tile (input is only read)
+        {
+            TRACE_SCOPE("tile-reduce");
+            #pragma omp for schedule(static) nowait
+            for (size_t t = 0; t < num_tiles; t++) {
+                size_t start = t * BLOCKED_TILE;
+                size_t end = min(start + BLOCKED_TILE, n);
+                int sum = 0;
+                for (size_t i = start; i < end; i++) {
+                    sum += arr[i];
+                }
+                tile_sums[t] = sum;
+            }
+        }
         #pragma omp barrier
         
-        cout << "Level " << (log_n - 1 - d) << " (stride=" << stride << "): ";
-        for (int i = 0; i < min(n, 16); i++) cout << temp[i] << " ";
-        cout << endl;
+        // Phase 2: exclusive Blelloch scan over the tile aggregates.
+        // Upsweep levels run in parallel while they have >= P nodes.
+        int d = 0;
+        for (; d < log_t; d++) {
+            size_t stride = size_t(1) << (d + 1);
+            size_t offset = (size_t(1) << d) - 1;
+            if ((num_tiles + stride - 1) / stride < (size_t)num_threads) break;
+            
+            #pragma omp for
+            for (size_t i = 0; i < num_tiles; i += stride) {
+                size_t left = i + offset;
+                size_t right = min(i + stride - 1, num_tiles - 1);
+                if (left < right) {
+                    tile_sums[right] += tile_sums[left];
+                }
+            }
+        }
+        int serial_from = d;
+        
+        // Top of the tree: too few nodes to be worth a barrier per level
+        #pragma omp single
+        {
+            TRACE_SCOPE("serial-tree-top");
+            for (int e = serial_from; e < log_t; e++) {
+                size_t stride = size_t(1) << (e + 1);
+                size_t offset = (size_t(1) << e) - 1;
+                for (size_t i = 0; i < num_tiles; i += stride) {
+                    size_t left = i + offset;
+                    size_t right = min(i + stride - 1, num_tiles - 1);
+                    if (left < right) {
+                        tile_sums[right] += tile_sums[left];
+                    }
+                }
+            }
+            
+            tile_sums[num_tiles - 1] = 0;
+            
+            for (int e = log_t - 1; e >= serial_from; e--) {
+                size_t stride = size_t(1) << (e + 1);
+                size_t offset = (size_t(1) << e) - 1;
+                for (size_t i = 0; i < num_tiles; i += stride) {
+                    size_t left = i + offset;
+                    size_t right = min(i + stride - 1, num_tiles - 1);
+                    if (left < right) {
+                        int t = tile_sums[left];
+                        tile_sums[left] = tile_sums[right];
+                        tile_sums[right] += t;
+                    }
+                }
+            }
+        }
+        
+        // Downsweep levels with enough nodes go back to the team
+        for (int e = serial_from - 1; e >= 0; e--) {
+            size_t stride = size_t(1) << (e + 1);
+            size_t offset = (size_t(1) << e) - 1;
+            
+            #pragma omp for
+            for (size_t i = 0; i < num_tiles; i += stride) {
+                size_t left = i + offset;
+                size_t right = min(i + stride - 1, num_tiles - 1);
+                if (left < right) {
+                    int t = tile_sums[left];
+                    tile_sums[left] = tile_sums[right];
+                    tile_sums[right] += t;
+                }
+            }
+        }
+        
+        // Phase 3: scan each tile starting from its exclusive prefix
+        TRACE_SCOPE("tile-scan");
+        #pragma omp for schedule(static) nowait
+        for (size_t t = 0; t < num_tiles; t++) {
+            size_t start = t * BLOCKED_TILE;
+            size_t end = min(start + BLOCKED_TILE, n);
+            scan_kernel(&arr[start], &out[start], end - start, tile_sums[t]);
+        }
     }
+}
+
+void parallel_prefix_sum_blelloch_blocked(span<int> data) {
+    parallel_prefix_sum_blelloch_blocked(data, data);
+}
+
+vector<int> parallel_prefix_sum_blelloch_blocked(const vector<int>& arr) {
+    vector<int> result(arr.size());
+    parallel_prefix_sum_blelloch_blocked(arr, result);
+    return result;
+}
+
+/**
+ * 64-bit and checked scans
+ * The int methods above wrap silently once the running sum passes
+ * INT_MAX (about 21M elements of the demo's 1..100 values). These
+ * variants accumulate in int64_t:
+ * - parallel_prefix_sum_wide: int32 input, int64 output
+ * - parallel_prefix_sum_checked: int32 output, plus a report of every
+ *   block whose running sum left the int range
+ * 
+ * Both reduce the blocks first (Phase 1), scan the block totals
+ * (Phase 2), then scan each block once from its exclusive prefix with a
+ * widening kernel (Phase 3), so the output is written exactly once.
+ */
+struct ScanOverflow {
+    int block;           // Block (thread chunk) index
+    size_t start;        // Block range [start, end)
+    size_t end;
+    size_t first_index;  // First element whose true prefix sum does not fit in int
+};
+
+/**
+ * Runs Phases 1 and 2, then calls scan_block(block, start, end, carry)
+ * for every block in parallel
+ */
+template <typename BlockScan>
+void widened_block_scan(span<const int> arr, int num_threads, BlockScan scan_block) {
+    size_t n = arr.size();
+    int64_t* block_sums = scan_scratch<int64_t, 0>(num_threads);
+    int64_t* block_prefix = scan_scratch<int64_t, 1>(num_threads);
+    size_t chunk_size = (n + num_threads - 1) / num_threads;
     
-    cout << endl;
-    cout << "Result (Exclusive): ";
-    for (int i = 0; i < min(n, 16); i++) cout << temp[i] << " ";
-    cout << endl;
-    
-    // Convert exclusive scan to inclusive scan
-    // Inclusive[i] = Exclusive[i] + Original[i]
-    vector<int> result(original_n);
-    for (int i = 0; i < original_n; i++) {
-        result[i] = temp[i] + arr[i];
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
+        
+        TRACE_SCOPE("block-reduce");
+        int64_t sum = 0;
+        for (size_t i = start; i < end; i++) {
+            sum += arr[i];
+        }
+        block_sums[tid] = sum;
+        
+        #pragma omp barrier
+        
+        #pragma omp single
+        {
+            TRACE_SCOPE("block-prefix");
+            block_prefix[0] = 0;
+            for (int b = 1; b < num_threads; b++) {
+                block_prefix[b] = block_prefix[b-1] + block_sums[b-1];
+            }
+        }
+        
+        if (start < end) {
+            TRACE_SCOPE("block-scan");
+            scan_block(tid, start, end, block_prefix[tid]);
+        }
     }
+}
+
+void parallel_prefix_sum_wide(span<const int> arr, span<int64_t> out) {
+    if (arr.empty()) return;
     
+    widened_block_scan(arr, omp_get_max_threads(), [&](int, size_t start, size_t end, int64_t carry) {
+        scan_kernel_wide(&arr[start], &out[start], end - start, carry);
+    });
+}
+
+vector<int64_t> parallel_prefix_sum_wide(const vector<int>& arr) {
+    vector<int64_t> result(arr.size());
+    parallel_prefix_sum_wide(arr, result);
     return result;
 }
 
 /**
- * Method 2: Simple Parallel Prefix Sum using OpenMP scan directive
- * (Available in OpenMP 5.0+)
+ * Scans into int like the other methods (wrapping on overflow) and
+ * returns the blocks that overflowed; an empty report means out is exact
+ */
+vector<ScanOverflow> parallel_prefix_sum_checked(span<const int> arr, span<int> out) {
+    vector<ScanOverflow> report;
+    if (arr.empty()) return report;
+    
+    size_t n = arr.size();
+    int num_threads = omp_get_max_threads();
+    size_t chunk_size = (n + num_threads - 1) / num_threads;
+    bool* block_overflow = scan_scratch<bool>(num_threads);
+    int64_t* block_carry = scan_scratch<int64_t, 2>(num_threads);
+    fill(block_overflow, block_overflow + num_threads, false);
+    
+    widened_block_scan(arr, num_threads, [&](int block, size_t start, size_t end, int64_t carry) {
+        block_carry[block] = carry;
+        scan_kernel_checked(&arr[start], &out[start], end - start, carry, block_overflow[block]);
+    });
+    
+    // Rare path: locate the first out-of-range element of each bad block.
+    // The input may have been overwritten (in-place call), so each element
+    // is recovered as the wrapped difference of consecutive outputs.
+    for (int b = 0; b < num_threads; b++) {
+        if (!block_overflow[b]) continue;
+        size_t start = b * chunk_size;
+        size_t end = min(start + chunk_size, n);
+        int64_t running = block_carry[b];
+        uint32_t prev = (uint32_t)running;
+        size_t first = start;
+        for (; first < end; first++) {
+            uint32_t cur = (uint32_t)out[first];
+            running += (int32_t)(cur - prev);
+            prev = cur;
+            if (running > INT_MAX || running < INT_MIN) break;
+        }
+        report.push_back({b, start, end, first});
+    }
+    return report;
+}
+
+vector<ScanOverflow> parallel_prefix_sum_checked(span<int> data) {
+    return parallel_prefix_sum_checked(data, data);
+}
+
+/**
+ * Sequential int64 reference for the widening scans
+ */
+void sequential_prefix_sum_wide(span<const int> arr, span<int64_t> out) {
+    int64_t running = 0;
+    for (size_t i = 0; i < arr.size(); i++) {
+        running += arr[i];
+        out[i] = running;
+    }
+}
+
+/**
+ * Generic Scan Engine: inclusive scans over any element type and any
+ * associative operator (monoid, see monoids.h)
  * 
- * This is simpler but may not be available in all OpenMP implementations
+ * The operator only has to be associative: every combine keeps the
+ * earlier element on the left, so non-commutative operators such as
+ * AffineOp (linear recurrences) scan correctly. Both engines accept the
+ * same span pairs as the int methods, and out may alias arr.
  */
-vector<int> parallel_prefix_sum_omp_scan(const vector<int>& arr) {
-    int n = arr.size();
-    vector<int> result(n);
+
+/**
+ * Block-based engine: the generic form of Method 2
+ * Each thread scans its block, the block totals are scanned serially,
+ * then every block folds in the total of the blocks before it.
+ */
+template <typename T, typename Op>
+void parallel_scan_blocks(span<const T> arr, span<T> out, Op op) {
+    size_t n = arr.size();
+    
+    if (n == 0) return;
+    
+    int num_threads = omp_get_max_threads();
+    T* block_sums = scan_scratch<T, 0>(num_threads);
+    T* block_prefix = scan_scratch<T, 1>(num_threads);
+    fill(block_sums, block_sums + num_threads, op.identity());
+    size_t chunk_size = (n + num_threads - 1) / num_threads;
+    
+    // Phase 1: Scan each block locally
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
+        
+        if (start < end) {
+            TRACE_SCOPE("block-scan");
+            T local = arr[start];
+            out[start] = local;
+            for (size_t i = start + 1; i < end; i++) {
+                local = op(local, arr[i]);
+                out[i] = local;
+            }
+            block_sums[tid] = local;
+        }
+    }
+    
+    // Phase 2: Exclusive scan of the block totals
+    {
+        TRACE_SCOPE("block-prefix");
+        block_prefix[0] = op.identity();
+        for (int i = 1; i < num_threads; i++) {
+            block_prefix[i] = op(block_prefix[i-1], block_sums[i-1]);
+        }
+    }
+    
+    // Phase 3: Prepend the prefix of the earlier blocks (block 0 has none)
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
+        
+        if (tid > 0) {
+            TRACE_SCOPE("fix-up");
+            T prefix = block_prefix[tid];
+            for (size_t i = start; i < end; i++) {
+                out[i] = op(prefix, out[i]);
+            }
+        }
+    }
+}
+
+/**
+ * Blelloch engine: the generic form of Method 1 (arbitrary N, no padding)
+ * Upsweep: right = left ⊕ right. Downsweep: the left child receives the
+ * parent prefix and the right child receives parent ⊕ left subtree.
+ */
+template <typename T, typename Op>
+void parallel_scan_blelloch(span<const T> arr, span<T> out, Op op) {
+    size_t n = arr.size();
+    
+    if (n == 0) return;
+    
+    int log_n = 0;
+    while ((size_t(1) << log_n) < n) log_n++;
+    
+    T* temp = out.data();
+    bool copy_in = (arr.data() != temp);
+    T total = op.identity();
     
     #pragma omp parallel
     {
-        #pragma omp for
-        for (int i = 0; i < n; i++) {
-            result[i] = arr[i];
+        if (copy_in) {
+            {
+                TRACE_SCOPE("copy-in");
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i++) {
+                    temp[i] = arr[i];
+                }
+            }
+            #pragma omp barrier
+        }
+        
+        for (int d = 0; d < log_n; d++) {
+            size_t stride = size_t(1) << (d + 1);
+            size_t offset = (size_t(1) << d) - 1;
+            
+            {
+                TRACE_SCOPE_ARG("upsweep", d);
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i += stride) {
+                    size_t left = i + offset;
+                    size_t right = min(i + stride - 1, n - 1);
+                    if (left < right) {
+                        temp[right] = op(temp[left], temp[right]);
+                    }
+                }
+            }
+            #pragma omp barrier
         }
         
-        // Note: OpenMP scan directive might not be available in all versions
-        // This is a simplified version
         #pragma omp single
         {
-            result[0] = arr[0];
-            for (int i = 1; i < n; i++) {
-                result[i] = result[i-1] + arr[i];
+            total = temp[n - 1];
+            temp[n - 1] = op.identity();
+        }
+        
+        for (int d = log_n - 1; d >= 0; d--) {
+            size_t stride = size_t(1) << (d + 1);
+            size_t offset = (size_t(1) << d) - 1;
+            
+            {
+                TRACE_SCOPE_ARG("downsweep", d);
+                #pragma omp for nowait
+                for (size_t i = 0; i < n; i += stride) {
+                    size_t left = i + offset;
+                    size_t right = min(i + stride - 1, n - 1);
+                    if (left < right) {
+                        T t = temp[left];
+                        temp[left] = temp[right];
+                        temp[right] = op(temp[right], t);
+                    }
+                }
             }
+            #pragma omp barrier
         }
+        
+        // Exclusive to inclusive by shifting left, as in Method 1
+        int tid = omp_get_thread_num();
+        int num_threads = omp_get_num_threads();
+        size_t chunk_size = (n + num_threads - 1) / num_threads;
+        size_t start = min(tid * chunk_size, n);
+        size_t end = min(start + chunk_size, n);
+        
+        T next = (end < n) ? temp[end] : total;
+        
+        #pragma omp barrier
+        
+        TRACE_SCOPE("exclusive-to-inclusive");
+        if (start < end) {
+            for (size_t i = start; i < end - 1; i++) {
+                temp[i] = temp[i + 1];
+            }
+            temp[end - 1] = next;
+        }
+    }
+}
+
+template <typename T, typename Op>
+vector<T> parallel_scan_blocks(span<const T> arr, Op op) {
+    vector<T> result(arr.size());
+    parallel_scan_blocks<T>(arr, result, op);
+    return result;
+}
+
+template <typename T, typename Op>
+vector<T> parallel_scan_blelloch(span<const T> arr, Op op) {
+    vector<T> result(arr.size());
+    parallel_scan_blelloch<T>(arr, result, op);
+    return result;
+}
+
+/**
+ * Serial inclusive scan with any operator, used as the reference
+ */
+template <typename T, typename Op>
+vector<T> sequential_scan(span<const T> arr, Op op) {
+    vector<T> result(arr.size());
+    T acc = op.identity();
+    for (size_t i = 0; i < arr.size(); i++) {
+        acc = op(acc, arr[i]);
+        result[i] = acc;
     }
-    
     return result;
 }
 
 /**
- * Method 3: Parallel Prefix Sum using divide and conquer
- * Good for understanding the parallel decomposition
+ * Solves x[i] = a[i]*x[i-1] + b[i] for all i in parallel, starting
+ * from x[-1] = x0, by scanning the affine maps (a[i], b[i])
  */
-vector<int> parallel_prefix_sum_recursive(const vector<int>& arr) {
-    int n = arr.size();
-    vector<int> result(n);
+vector<double> parallel_linear_recurrence(const vector<double>& a, const vector<double>& b, double x0) {
+    size_t n = a.size();
+    vector<Affine<double>> maps(n);
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; i++) {
+        maps[i] = {a[i], b[i]};
+    }
+    
+    parallel_scan_blocks<Affine<double>>(maps, maps, AffineOp<double>());
+    
+    vector<double> x(n);
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; i++) {
+        x[i] = maps[i].a * x0 + maps[i].b;
+    }
+    return x;
+}
+
+/**
+ * Segmented Scans: an independent scan inside every segment of a packed
+ * array (segments.h), in one pass over all of them
+ * 
+ * The segmented form of parallel_scan_blocks, split by element count:
+ *   - Phase 1: each thread scans its chunk, restarting from the identity
+ *     at every head, and records the running value at its chunk end and
+ *     whether the chunk contains a head.
+ *   - Phase 2: the carry into chunk t is the carry into t-1 extended by
+ *     the tail of t-1, or just that tail if t-1 contains a head.
+ *   - Phase 3: each thread prepends its carry to the elements before its
+ *     first head; everything after a head is already final.
+ * Inclusive: out[i] covers the segment up to and including i. Exclusive:
+ * up to but excluding i, so every head gets the identity. out may alias
+ * arr. The CSR overloads convert the offsets to flags first.
+ */
+template <typename T, typename Op>
+void segmented_scan_blocks(span<const T> arr, span<const uint8_t> flags, span<T> out, Op op, bool inclusive) {
+    size_t n = arr.size();
     
-    if (n == 0) return result;
+    if (n == 0) return;
     
     int num_threads = omp_get_max_threads();
-    vector<int> block_sums(num_threads, 0);
+    T* chunk_tail = scan_scratch<T, 0>(num_threads);
+    T* chunk_carry = scan_scratch<T, 1>(num_threads);
+    // Slots 0 and 1 hold T, so the index buffer takes slot 2: with
+    // T = size_t the same slot would return the same buffer
+    size_t* first_head = scan_scratch<size_t, 2>(num_threads);
     
-    // Phase 1: Compute prefix sum in each block
-    #pragma omp parallel
+    // Phase 1: Scan each chunk locally, restarting at every head
+    #pragma omp parallel num_threads(num_threads)
     {
         int tid = omp_get_thread_num();
-        int chunk_size = (n + num_threads - 1) / num_threads;
-        int start = tid * chunk_size;
-        int end = min(start + chunk_size, n);
+        size_t start, end;
+        static_chunk(n, tid, num_threads, start, end);
         
-        if (start < end) {
-            result[start] = arr[start];
-            int local_sum = arr[start];
-            
-            for (int i = start + 1; i < end; i++) {
-                local_sum += arr[i];
-                result[i] = local_sum;
+        TRACE_SCOPE("segment-scan");
+        T acc = op.identity();
+        size_t head = end;
+        for (size_t i = start; i < end; i++) {
+            if (flags[i]) {
+                acc = op.identity();
+                head = min(head, i);
+            }
+            T x = arr[i];
+            if (inclusive) {
+                acc = op(acc, x);
+                out[i] = acc;
+            } else {
+                out[i] = acc;
+                acc = op(acc, x);
             }
-            
-            block_sums[tid] = local_sum;
         }
+        chunk_tail[tid] = acc;
+        first_head[tid] = head;
     }
     
-    // Phase 2: Compute prefix sum of block sums (sequential for simplicity)
-    vector<int> block_prefix(num_threads);
-    block_prefix[0] = 0;
-    for (int i = 1; i < num_threads; i++) {
-        block_prefix[i] = block_prefix[i-1] + block_sums[i-1];
+    // Phase 2: Carry into each chunk from the open segment before it
+    {
+        TRACE_SCOPE("segment-carry");
+        chunk_carry[0] = op.identity();
+        for (int t = 1; t < num_threads; t++) {
+            size_t prev_start, prev_end;
+            static_chunk(n, t - 1, num_threads, prev_start, prev_end);
+            bool restarted = first_head[t - 1] < prev_end;
+            chunk_carry[t] = restarted ? chunk_tail[t - 1] : op(chunk_carry[t - 1], chunk_tail[t - 1]);
+        }
     }
     
-    // Phase 3: Add block prefix to each element
-    #pragma omp parallel
+    // Phase 3: Prepend the carry up to the first head (chunk 0 has none)
+    #pragma omp parallel num_threads(num_threads)
     {
         int tid = omp_get_thread_num();
-        int chunk_size = (n + num_threads - 1) / num_threads;
-        int start = tid * chunk_size;
-        int end = min(start + chunk_size, n);
+        size_t start, end;
+        static_chunk(n, tid, num_threads, start, end);
         
-        for (int i = start; i < end; i++) {
-            result[i] += block_prefix[tid];
+        if (tid > 0) {
+            TRACE_SCOPE("segment-fix-up");
+            T carry = chunk_carry[tid];
+            for (size_t i = start; i < first_head[tid]; i++) {
+                out[i] = op(carry, out[i]);
+            }
         }
     }
-    
+}
+
+template <typename T, typename Op>
+void parallel_segmented_inclusive_scan(span<const T> arr, span<const uint8_t> flags, span<T> out, Op op) {
+    segmented_scan_blocks<T>(arr, flags, out, op, true);
+}
+
+template <typename T, typename Op>
+void parallel_segmented_exclusive_scan(span<const T> arr, span<const uint8_t> flags, span<T> out, Op op) {
+    segmented_scan_blocks<T>(arr, flags, out, op, false);
+}
+
+template <typename T, typename Op>
+void parallel_segmented_inclusive_scan(span<const T> arr, span<const size_t> offsets, span<T> out, Op op) {
+    uint8_t* flags = scan_scratch<uint8_t, 3>(arr.size());  // Clear of the slots the engine uses
+    segment_flags_from_offsets(offsets.data(), offsets.size() - 1, flags);
+    segmented_scan_blocks<T>(arr, span<const uint8_t>(flags, arr.size()), out, op, true);
+}
+
+template <typename T, typename Op>
+void parallel_segmented_exclusive_scan(span<const T> arr, span<const size_t> offsets, span<T> out, Op op) {
+    uint8_t* flags = scan_scratch<uint8_t, 3>(arr.size());  // Clear of the slots the engine uses
+    segment_flags_from_offsets(offsets.data(), offsets.size() - 1, flags);
+    segmented_scan_blocks<T>(arr, span<const uint8_t>(flags, arr.size()), out, op, false);
+}
+
+template <typename T, typename Op>
+vector<T> parallel_segmented_inclusive_scan(span<const T> arr, span<const uint8_t> flags, Op op) {
+    vector<T> result(arr.size());
+    parallel_segmented_inclusive_scan<T>(arr, flags, result, op);
+    return result;
+}
+
+template <typename T, typename Op>
+vector<T> parallel_segmented_exclusive_scan(span<const T> arr, span<const uint8_t> flags, Op op) {
+    vector<T> result(arr.size());
+    parallel_segmented_exclusive_scan<T>(arr, flags, result, op);
+    return result;
+}
+
+/**
+ * Serial segmented scan over head flags, used as the reference
+ */
+template <typename T, typename Op>
+vector<T> sequential_segmented_scan(span<const T> arr, span<const uint8_t> flags, Op op, bool inclusive) {
+    vector<T> result(arr.size());
+    T acc = op.identity();
+    for (size_t i = 0; i < arr.size(); i++) {
+        if (flags[i]) acc = op.identity();
+        result[i] = inclusive ? op(acc, arr[i]) : acc;
+        acc = op(acc, arr[i]);
+    }
     return result;
 }
 
+// ============================================================================
+// Streaming Scan: unbounded input through fixed-size chunks
+// ============================================================================
+
+const size_t STREAM_CHUNK = 1 << 20;  // Default chunk: 2^20 ints (4 MB)
+
+struct StreamScanStats {
+    size_t elements = 0;
+    size_t chunks = 0;
+    double scan_seconds = 0;  // Spent in the parallel chunk scans
+    double wait_seconds = 0;  // Spent waiting for I/O after a scan finished
+};
+
+/**
+ * Inclusive prefix sum of a stream of raw native int32 values (a pipe,
+ * a socket or a file) written to another stream in the same format.
+ * Memory stays at two chunk buffers however long the stream is.
+ *
+ * Each chunk is scanned in place with parallel_prefix_sum_recursive. The
+ * running total of all earlier chunks is folded into the first element
+ * before the scan, so the carry costs no extra pass. While the OpenMP team
+ * scans one buffer, an I/O thread writes the previous result from the
+ * other buffer and then reads the next chunk into it:
+ *
+ *     buffer A:  read k   | scan k        | write k, read k+2 | ...
+ *     buffer B:           | write k-1,    | scan k+1          | ...
+ *                         | read k+1      |                   |
+ *
+ * The sums wrap like the int scans do. Returns false with error set on
+ * a read or write error, or if the input ends inside an element.
+ */
+bool parallel_prefix_sum_stream(FILE* in, FILE* out, size_t chunk_size, StreamScanStats& stats, string& error) {
+    stats = StreamScanStats();
+    if (chunk_size == 0) {
+        error = "chunk size must be positive";
+        return false;
+    }
+
+    vector<int> buffers[2] = {vector<int>(chunk_size), vector<int>(chunk_size)};
+    size_t filled[2] = {0, 0};
+    string io_error;
+
+    // fread blocks until the chunk is full or the stream ends, so short
+    // reads from a pipe only happen on the last chunk
+    auto read_chunk = [&](int b) {
+        size_t bytes = fread(buffers[b].data(), 1, chunk_size * sizeof(int), in);
+        filled[b] = bytes / sizeof(int);
+        if (ferror(in)) {
+            io_error = "read error on the input stream";
+            return false;
+        }
+        if (bytes % sizeof(int) != 0) {
+            io_error = "input ends inside an element (" + to_string(bytes % sizeof(int)) + " trailing bytes)";
+            return false;
+        }
+        return true;
+    };
+    auto write_chunk = [&](int b, size_t count) {
+        if (fwrite(buffers[b].data(), sizeof(int), count, out) != count) {
+            io_error = "write error on the output stream";
+            return false;
+        }
+        return true;
+    };
+
+    if (!read_chunk(0)) {
+        error = io_error;
+        return false;
+    }
+
+    int cur = 0;
+    int carry = 0;
+    size_t pending = 0;  // Scanned elements in the other buffer not yet written
+
+    while (filled[cur] > 0) {
+        int other = 1 - cur;
+        size_t to_write = pending;
+        bool io_ok = true;
+        thread io([&, other, to_write]() {
+            io_ok = (to_write == 0 || write_chunk(other, to_write)) && read_chunk(other);
+        });
+
+        size_t n = filled[cur];
+        span<int> chunk(buffers[cur].data(), n);
+        chunk[0] = (int)((uint32_t)chunk[0] + (uint32_t)carry);
+        double start = omp_get_wtime();
+        parallel_prefix_sum_recursive(chunk);
+        double end = omp_get_wtime();
+        carry = chunk[n - 1];
+
+        io.join();
+        stats.scan_seconds += end - start;
+        stats.wait_seconds += omp_get_wtime() - end;
+        stats.elements += n;
+        stats.chunks++;
+        if (!io_ok) {
+            error = io_error;
+            return false;
+        }
+
+        pending = n;
+        cur = other;
+    }
+
+    // Nothing is left to read; the last scanned chunk is in the other buffer
+    if ((pending > 0 && !write_chunk(1 - cur, pending)) || fflush(out) != 0) {
+        error = io_error.empty() ? "write error on the output stream" : io_error;
+        return false;
+    }
+    return true;
+}
+
 /**
  * Sequential prefix sum for comparison
  */
-vector<int> sequential_prefix_sum(const vector<int>& arr) {
-    int n = arr.size();
-    vector<int> result(n);
+void sequential_prefix_sum(span<const int> arr, span<int> out) {
+    size_t n = arr.size();
     
-    if (n == 0) return result;
+    if (n == 0) return;
     
-    result[0] = arr[0];
-    for (int i = 1; i < n; i++) {
-        result[i] = result[i-1] + arr[i];
+    out[0] = arr[0];
+    for (size_t i = 1; i < n; i++) {
+        out[i] = out[i-1] + arr[i];
     }
-    
+}
+
+void sequential_prefix_sum(span<int> data) {
+    sequential_prefix_sum(data, data);
+}
+
+vector<int> sequential_prefix_sum(const vector<int>& arr) {
+    vector<int> result(arr.size());
+    sequential_prefix_sum(arr, result);
     return result;
 }
 
 /**
  * Function to print array
  */
-void print_array(const vector<int>& arr, const string& name) {
+void print_array(span<const int> arr, const string& name) {
     cout << name << ": [";
     for (size_t i = 0; i < arr.size(); i++) {
         cout << arr[i];
@@ -250,9 +1489,213 @@ bool verify_arrays(const vector<int>& a, const vector<int>& b) {
     return true;
 }
 
-int main() {
-    // Seed for random number generation
-    srand(time(NULL));
+/**
+ * Checks an inclusive scan against a running sum of the input in one
+ * pass. The int version wraps like the int scans do.
+ */
+bool verify_scan(span<const int> arr, span<const int> out) {
+    if (arr.size() != out.size()) return false;
+    
+    uint32_t running = 0;
+    for (size_t i = 0; i < arr.size(); i++) {
+        running += (uint32_t)arr[i];
+        if (out[i] != (int)running) return false;
+    }
+    return true;
+}
+
+bool verify_scan(span<const int> arr, span<const int64_t> out) {
+    if (arr.size() != out.size()) return false;
+    
+    int64_t running = 0;
+    for (size_t i = 0; i < arr.size(); i++) {
+        running += arr[i];
+        if (out[i] != running) return false;
+    }
+    return true;
+}
+
+/**
+ * Same check for a segmented inclusive sum: the running sum restarts at
+ * every head flag
+ */
+bool verify_scan(span<const int> arr, span<const uint8_t> flags, span<const int> out) {
+    if (arr.size() != out.size() || arr.size() != flags.size()) return false;
+    
+    uint32_t running = 0;
+    for (size_t i = 0; i < arr.size(); i++) {
+        if (flags[i]) running = 0;
+        running += (uint32_t)arr[i];
+        if (out[i] != (int)running) return false;
+    }
+    return true;
+}
+
+/**
+ * Floating-point variant: the parallel scans combine in a different order
+ * than the serial one, so results may differ by rounding
+ */
+bool verify_arrays_close(const vector<double>& a, const vector<double>& b, double rel_tol = 1e-9) {
+    if (a.size() != b.size()) return false;
+    
+    for (size_t i = 0; i < a.size(); i++) {
+        if (fabs(a[i] - b[i]) > rel_tol * max(1.0, fabs(b[i]))) {
+            cout << "Mismatch at index " << i << ": " << a[i] << " != " << b[i] << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Benchmark mode: runs the methods selected on the command line
+ * (see benchmark.h) instead of the interactive demo
+ */
+int benchmark_main(int argc, char** argv) {
+    BenchmarkOptions opts;
+    string error;
+    if (!parse_benchmark_options(argc, argv, opts, error)) {
+        if (!error.empty()) cerr << "Error: " << error << endl;
+        print_benchmark_usage(argv[0]);
+        return error.empty() ? 0 : 1;
+    }
+    
+    debug_output = false;
+    
+    // Input: generated from the seed, or a memory-mapped file used in place.
+    // Output: a vector, or a mapped file when --output is given.
+    // Generated arrays are placed with the threads that use them (--numa)
+    NumaArray<int> generated;
+    NumaArray<int> out_buffer;
+    NumaArray<int64_t> out_wide;
+    MappedArray<int> mapped_in;
+    MappedArray<int> mapped_out;
+    MapOptions map_options = benchmark_map_options(opts);
+    
+    if (!opts.input_path.empty()) {
+        if (!mapped_in.open(opts.input_path, map_options, error)) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+        opts.sizes = {mapped_in.size()};
+    }
+    if (!opts.output_path.empty()) {
+        if (opts.input_path.empty()) {
+            cerr << "Error: --output needs --input" << endl;
+            return 1;
+        }
+        if (!mapped_out.create(opts.output_path, mapped_in.size(), map_options, error)) {
+            cerr << "Error: " << error << endl;
+            return 1;
+        }
+    }
+    
+    // The int64 output is only allocated when the widening scan runs
+    bool need_wide = false;
+    for (const string& name : opts.methods) {
+        need_wide = need_wide || name == "all" || name == "wide";
+    }
+    
+    span<const int> arr;
+    span<int> out;
+    const size_t SEGMENT_LENGTH = 32;
+    vector<uint8_t> segment_flags;
+    
+    auto prepare = [&](size_t n, uint64_t seed) {
+        if (mapped_in.size() > 0) {
+            arr = span<const int>(mapped_in.data(), n);
+        } else {
+            generated.allocate(n, opts.numa);
+            fill_input(generated.data(), n, opts.distribution, seed, 1, 100);  // Same range as the interactive mode
+            arr = span<const int>(generated.data(), n);
+        }
+        if (mapped_out.size() > 0) {
+            out = span<int>(mapped_out.data(), n);
+        } else {
+            out_buffer.allocate(n, opts.numa);
+            out = span<int>(out_buffer.data(), n);
+        }
+        if (need_wide) out_wide.allocate(n, opts.numa);
+        
+        // Random groups with a mean length of SEGMENT_LENGTH
+        vector<size_t> offsets = random_segment_offsets(n, SEGMENT_LENGTH, seed);
+        segment_flags.resize(n);
+        segment_flags_from_offsets(offsets.data(), offsets.size() - 1, segment_flags.data());
+    };
+    
+    // Verified against a running sum, without a reference copy, so
+    // mapped inputs larger than RAM can be checked too
+    auto check = [&]() { return verify_scan(arr, out); };
+    auto check_wide = [&]() { return verify_scan(arr, span<const int64_t>(out_wide.data(), out_wide.size())); };
+    auto check_segmented = [&]() { return verify_scan(arr, segment_flags, out); };
+    
+    // Every method scans into the same preallocated output buffer;
+    // compulsory traffic is one int read and one int written per element
+    // (one int64 written for the widening scan, one flag read more for
+    // the segmented scan)
+    vector<BenchmarkMethod> methods = {
+        {"blelloch", [&]() { parallel_prefix_sum_blelloch(arr, out); }, check, 8},
+        {"recursive", [&]() { parallel_prefix_sum_recursive(arr, out); }, check, 8},
+        {"lookback", [&]() { parallel_prefix_sum_lookback(arr, out); }, check, 8},
+        {"blocked", [&]() { parallel_prefix_sum_blelloch_blocked(arr, out); }, check, 8},
+        {"omp_scan", [&]() { parallel_prefix_sum_omp_scan(arr, out); }, check, 8},
+        {"generic_blocks", [&]() { parallel_scan_blocks<int>(arr, out, SumOp<int>()); }, check, 8},
+        {"generic_blelloch", [&]() { parallel_scan_blelloch<int>(arr, out, SumOp<int>()); }, check, 8},
+        {"wide", [&]() { parallel_prefix_sum_wide(arr, span<int64_t>(out_wide.data(), out_wide.size())); }, check_wide, 12},
+        {"checked", [&]() { parallel_prefix_sum_checked(arr, out); }, check, 8},
+        {"segmented", [&]() { parallel_segmented_inclusive_scan<int>(arr, segment_flags, out, SumOp<int>()); }, check_segmented, 9},
+        {"sequential", [&]() { sequential_prefix_sum(arr, out); }, check, 8},
+    };
+    
+    return run_benchmark(opts, methods, prepare, cout);
+}
+
+/**
+ * Stream mode: scans raw int32 from stdin to stdout, e.g.
+ *     ./prefix_sum_scan --stream --chunk=4M < in.bin > out.bin
+ * Statistics go to stderr so they never mix with the output.
+ */
+int stream_main(int argc, char** argv) {
+    size_t chunk_size = STREAM_CHUNK;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--chunk=", 0) == 0 && parse_size(arg.substr(8), chunk_size) && chunk_size > 0) continue;
+        cerr << "Error: unknown or invalid option " << arg << endl;
+        cerr << "Usage: " << argv[0] << " --stream [--chunk=N]   (N elements per chunk, K/M/G suffixes, default 1048576)" << endl;
+        return 1;
+    }
+
+    debug_output = false;
+
+    StreamScanStats stats;
+    string error;
+    double start = omp_get_wtime();
+    bool ok = parallel_prefix_sum_stream(stdin, stdout, chunk_size, stats, error);
+    double end = omp_get_wtime();
+    if (!ok) {
+        cerr << "Error: " << error << endl;
+        return 1;
+    }
+
+    double seconds = end - start;
+    cerr << "Streamed " << stats.elements << " elements in " << stats.chunks << " chunks of " << chunk_size
+         << ": " << seconds * 1000 << " ms total, " << stats.scan_seconds * 1000 << " ms scanning, "
+         << stats.wait_seconds * 1000 << " ms waiting for I/O";
+    if (seconds > 0) cerr << ", " << stats.elements * sizeof(int) / seconds / 1e6 << " MB/s";
+    cerr << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--stream") {
+        return stream_main(argc, argv);
+    }
+    if (argc > 1) {
+        return benchmark_main(argc, argv);
+    }
+    
+    // Seed for the counter-based generator (random_input.h)
+    uint64_t seed = time(NULL);
     
     cout << "==================================================" << endl;
     cout << "    PARALLEL PREFIX SUM (SCAN) - OpenMP" << endl;
@@ -260,21 +1703,29 @@ int main() {
     cout << endl;
     
     // Get array size from user
-    int n;
+    long long requested;
     cout << "Ingrese el tamaño del arreglo: ";
-    cin >> n;
+    cin >> requested;
     
-    if (n <= 0) {
+    if (requested <= 0) {
         cout << "Error: El tamaño debe ser mayor que 0" << endl;
         return 1;
     }
+    size_t n = requested;
     
-    // Generate random array
-    vector<int> arr(n);
-    cout << "\nGenerando arreglo aleatorio de " << n << " elementos..." << endl;
-    for (int i = 0; i < n; i++) {
-        arr[i] = rand() % 100 + 1;  // Random values between 1 and 100
-    }
+    // Set number of threads before the input is filled, so its pages are
+    // first touched with the partition the methods use
+    int num_threads = 4;
+    omp_set_num_threads(num_threads);
+    
+    // Generate random array, its pages placed with the threads that read
+    // them (same static_chunk partition as the methods). The methods read
+    // it through span overloads that write into caller-allocated results.
+    NumaArray<int> input;
+    input.allocate(n, NumaPolicy::Touch);
+    cout << "\nGenerando arreglo aleatorio de " << n << " elementos (semilla " << seed << ")..." << endl;
+    fill_input(input.data(), n, Distribution::Uniform, seed, 1, 100);  // Random values between 1 and 100
+    span<const int> arr(input.data(), n);
     
     cout << endl;
     
@@ -291,9 +1742,6 @@ int main() {
     }
     cout << endl;
     
-    // Set number of threads
-    int num_threads = 4;
-    omp_set_num_threads(num_threads);
     cout << "Number of OpenMP threads: " << num_threads << endl;
     cout << endl;
     
@@ -301,8 +1749,9 @@ int main() {
     cout << "==================================================" << endl;
     cout << "Sequential Prefix Sum (Reference)" << endl;
     cout << "==================================================" << endl;
+    vector<int> result_seq(n);
     double start = omp_get_wtime();
-    vector<int> result_seq = sequential_prefix_sum(arr);
+    sequential_prefix_sum(arr, result_seq);
     double end = omp_get_wtime();
     
     if (n <= 20) {
@@ -324,9 +1773,15 @@ int main() {
     cout << "==================================================" << endl;
     cout << "Method 1: Blelloch Scan (Two-Phase)" << endl;
     cout << "==================================================" << endl;
+    // Untimed run that prints every level, then a quiet timed run so
+    // the printing does not end up in the measurement
+    vector<int> result1(n);
+    parallel_prefix_sum_blelloch(arr, result1);
+    debug_output = false;
     start = omp_get_wtime();
-    vector<int> result1 = parallel_prefix_sum_blelloch(arr);
+    parallel_prefix_sum_blelloch(arr, result1);
     end = omp_get_wtime();
+    debug_output = true;
     
     if (n <= 20) {
         print_array(result1, "Result P");
@@ -344,12 +1799,13 @@ int main() {
     cout << "Verification: " << (verify_arrays(result1, result_seq) ? "PASSED ✓" : "FAILED ✗") << endl;
     cout << endl;
     
-    // Method 3: Divide and Conquer
+    // Method 2: Divide and Conquer
     cout << "==================================================" << endl;
     cout << "Method 2: Divide and Conquer (Block-based)" << endl;
     cout << "==================================================" << endl;
+    vector<int> result3(n);
     start = omp_get_wtime();
-    vector<int> result3 = parallel_prefix_sum_recursive(arr);
+    parallel_prefix_sum_recursive(arr, result3);
     end = omp_get_wtime();
     
     if (n <= 20) {
@@ -368,6 +1824,261 @@ int main() {
     cout << "Verification: " << (verify_arrays(result3, result_seq) ? "PASSED ✓" : "FAILED ✗") << endl;
     cout << endl;
     
+    // Method 3: Decoupled Look-back
+    cout << "==================================================" << endl;
+    cout << "Method 3: Single-Pass Decoupled Look-back" << endl;
+    cout << "==================================================" << endl;
+    vector<int> result4(n);
+    start = omp_get_wtime();
+    parallel_prefix_sum_lookback(arr, result4);
+    end = omp_get_wtime();
+    
+    if (n <= 20) {
+        print_array(result4, "Result P");
+    } else {
+        cout << "Result P (primeros 20 elementos): [";
+        for (int i = 0; i < 20; i++) {
+            cout << result4[i];
+            if (i < 19) cout << ", ";
+        }
+        cout << ", ...]" << endl;
+        cout << "Último elemento (suma total): " << result4[n-1] << endl;
+    }
+    
+    cout << "Time: " << (end - start) * 1000 << " ms" << endl;
+    cout << "Verification: " << (verify_arrays(result4, result_seq) ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << endl;
+    
+    // Method 4: Cache-blocked hybrid Blelloch
+    cout << "==================================================" << endl;
+    cout << "Method 4: Cache-Blocked Hybrid Blelloch" << endl;
+    cout << "==================================================" << endl;
+    vector<int> result5(n);
+    start = omp_get_wtime();
+    parallel_prefix_sum_blelloch_blocked(arr, result5);
+    end = omp_get_wtime();
+    
+    if (n <= 20) {
+        print_array(result5, "Result P");
+    } else {
+        cout << "Result P (primeros 20 elementos): [";
+        for (int i = 0; i < 20; i++) {
+            cout << result5[i];
+            if (i < 19) cout << ", ";
+        }
+        cout << ", ...]" << endl;
+        cout << "Último elemento (suma total): " << result5[n-1] << endl;
+    }
+    
+    cout << "Time: " << (end - start) * 1000 << " ms" << endl;
+    cout << "Verification: " << (verify_arrays(result5, result_seq) ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << endl;
+    
+    // Caller-buffer and in-place APIs: the buffer is allocated once and reused
+    cout << "==================================================" << endl;
+    cout << "Caller-Buffer and In-Place APIs" << endl;
+    cout << "==================================================" << endl;
+    vector<int> buffer(n);
+    
+    parallel_prefix_sum_recursive(arr, buffer);
+    bool buffers_ok = verify_arrays(buffer, result_seq);
+    parallel_prefix_sum_lookback(arr, buffer);
+    buffers_ok = buffers_ok && verify_arrays(buffer, result_seq);
+    
+    copy(arr.begin(), arr.end(), buffer.begin());
+    start = omp_get_wtime();
+    parallel_prefix_sum_lookback(span<int>(buffer));
+    end = omp_get_wtime();
+    buffers_ok = buffers_ok && verify_arrays(buffer, result_seq);
+    cout << "In-place look-back time: " << (end - start) * 1000 << " ms" << endl;
+    
+    copy(arr.begin(), arr.end(), buffer.begin());
+    parallel_prefix_sum_recursive(span<int>(buffer));
+    buffers_ok = buffers_ok && verify_arrays(buffer, result_seq);
+    
+    // NUMA-placed input and output, partitioned like Method 2
+    NumaArray<int> placed_in, placed_out;
+    placed_in.allocate(n, NumaPolicy::Bind);
+    placed_out.allocate(n, NumaPolicy::Bind);
+    copy(arr.begin(), arr.end(), placed_in.begin());
+    parallel_prefix_sum_recursive(span<const int>(placed_in.data(), n), span<int>(placed_out.data(), n));
+    buffers_ok = buffers_ok && equal(placed_out.begin(), placed_out.end(), result_seq.begin());
+    cout << "NUMA-placed buffers (" << numa_node_count() << " node(s)" << (placed_in.bound() ? ", bound" : "")
+         << "): " << (equal(placed_out.begin(), placed_out.end(), result_seq.begin()) ? "OK" : "MISMATCH") << endl;
+    
+    cout << "Verification: " << (buffers_ok ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << endl;
+    
+    // 64-bit and checked scans
+    cout << "==================================================" << endl;
+    cout << "64-bit and Checked Scans" << endl;
+    cout << "==================================================" << endl;
+    vector<int64_t> wide_seq(n);
+    sequential_prefix_sum_wide(arr, wide_seq);
+    vector<int64_t> wide_result(n);
+    start = omp_get_wtime();
+    parallel_prefix_sum_wide(arr, wide_result);
+    end = omp_get_wtime();
+    bool wide_ok = (wide_result == wide_seq);
+    cout << "int32 -> int64 scan time: " << (end - start) * 1000 << " ms, total = " << wide_result[n-1] << endl;
+    
+    vector<ScanOverflow> overflows = parallel_prefix_sum_checked(arr, buffer);
+    bool fits_int = (wide_seq[n-1] <= INT_MAX);
+    wide_ok = wide_ok && (overflows.empty() == fits_int);
+    cout << "Checked scan: " << (overflows.empty() ? "no overflow" : "overflow detected") << endl;
+    
+    // Values near 2^28 overflow int after 8 elements
+    vector<int> large(n);
+    for (size_t i = 0; i < n; i++) large[i] = (1 << 28) + arr[i];
+    overflows = parallel_prefix_sum_checked(span<int>(large));
+    bool large_overflows = (n > 7);
+    wide_ok = wide_ok && (overflows.empty() != large_overflows);
+    for (const ScanOverflow& o : overflows) {
+        cout << "  Block " << o.block << " [" << o.start << ", " << o.end << "): first overflow at index " << o.first_index << endl;
+    }
+    if (large_overflows && !overflows.empty()) {
+        wide_ok = wide_ok && (overflows[0].first_index == 7);
+    }
+    
+    cout << "Verification: " << (wide_ok ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << endl;
+    
+    // Generic scan engine: other operators and a linear recurrence
+    cout << "==================================================" << endl;
+    cout << "Generic Scan Engine (any associative operator)" << endl;
+    cout << "==================================================" << endl;
+    bool generic_ok = verify_arrays(parallel_scan_blocks(arr, SumOp<int>()), result_seq) &&
+                      verify_arrays(parallel_scan_blelloch(arr, SumOp<int>()), result_seq);
+    
+    vector<int> max_seq = sequential_scan(arr, MaxOp<int>());
+    bool max_ok = verify_arrays(parallel_scan_blocks(arr, MaxOp<int>()), max_seq) &&
+                  verify_arrays(parallel_scan_blelloch(arr, MaxOp<int>()), max_seq);
+    cout << "Prefix max: " << (max_ok ? "OK" : "MISMATCH") << " (max = " << max_seq[n-1] << ")" << endl;
+    
+    vector<int> min_seq = sequential_scan(arr, MinOp<int>());
+    bool min_ok = verify_arrays(parallel_scan_blocks(arr, MinOp<int>()), min_seq) &&
+                  verify_arrays(parallel_scan_blelloch(arr, MinOp<int>()), min_seq);
+    cout << "Prefix min: " << (min_ok ? "OK" : "MISMATCH") << " (min = " << min_seq[n-1] << ")" << endl;
+    
+    // Factors close to 1 keep the running product finite for large n
+    vector<double> factors(n);
+    for (size_t i = 0; i < n; i++) factors[i] = 1.0 + (arr[i] - 50) * 1e-7;
+    vector<double> product_seq = sequential_scan<double>(factors, ProductOp<double>());
+    bool product_ok = verify_arrays_close(parallel_scan_blocks<double>(factors, ProductOp<double>()), product_seq) &&
+                      verify_arrays_close(parallel_scan_blelloch<double>(factors, ProductOp<double>()), product_seq);
+    cout << "Prefix product: " << (product_ok ? "OK" : "MISMATCH") << " (product = " << product_seq[n-1] << ")" << endl;
+    
+    // x[i] = a[i]*x[i-1] + b[i], with |a[i]| < 1 so x stays bounded
+    vector<double> coef_a(n), coef_b(n), x_seq(n);
+    double x_prev = 1.0;
+    for (size_t i = 0; i < n; i++) {
+        coef_a[i] = 0.5 + (arr[i] % 50) / 100.0;
+        coef_b[i] = arr[i];
+        x_prev = coef_a[i] * x_prev + coef_b[i];
+        x_seq[i] = x_prev;
+    }
+    start = omp_get_wtime();
+    vector<double> x_par = parallel_linear_recurrence(coef_a, coef_b, 1.0);
+    end = omp_get_wtime();
+    bool recurrence_ok = verify_arrays_close(x_par, x_seq);
+    cout << "Linear recurrence x[i] = a[i]*x[i-1] + b[i]: " << (recurrence_ok ? "OK" : "MISMATCH")
+         << " (x[n-1] = " << x_par[n-1] << ", " << (end - start) * 1000 << " ms)" << endl;
+    
+    generic_ok = generic_ok && max_ok && min_ok && product_ok && recurrence_ok;
+    cout << "Verification: " << (generic_ok ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << endl;
+    
+    // Segmented scans over random groups (some empty), given as head flags
+    // and as CSR offsets, against a serial scan that restarts at every head
+    cout << "==================================================" << endl;
+    cout << "Segmented Scans (head flags / CSR offsets)" << endl;
+    cout << "==================================================" << endl;
+    bool segmented_ok = true;
+    for (size_t mean_length : {size_t(1), size_t(32), n}) {
+        vector<size_t> offsets = random_segment_offsets(n, mean_length, seed + mean_length);
+        vector<uint8_t> flags(n);
+        segment_flags_from_offsets(offsets.data(), offsets.size() - 1, flags.data());
+        // size_t elements: the engine's T scratch buffers must stay apart
+        // from its size_t head-index buffer
+        vector<size_t> arr_size_t(arr.begin(), arr.end());
+        
+        for (bool inclusive : {true, false}) {
+            vector<int> sum_seq = sequential_segmented_scan(arr, flags, SumOp<int>(), inclusive);
+            vector<int> max_seq = sequential_segmented_scan(arr, flags, MaxOp<int>(), inclusive);
+            vector<size_t> size_t_seq = sequential_segmented_scan<size_t>(arr_size_t, flags, SumOp<size_t>(), inclusive);
+            for (int threads : {1, 3, num_threads}) {
+                omp_set_num_threads(threads);
+                vector<int> sum_csr(n);
+                if (inclusive) {
+                    parallel_segmented_inclusive_scan<int>(arr, span<const size_t>(offsets), sum_csr, SumOp<int>());
+                    segmented_ok = segmented_ok && verify_arrays(parallel_segmented_inclusive_scan(arr, flags, SumOp<int>()), sum_seq) &&
+                                   verify_arrays(parallel_segmented_inclusive_scan(arr, flags, MaxOp<int>()), max_seq);
+                } else {
+                    parallel_segmented_exclusive_scan<int>(arr, span<const size_t>(offsets), sum_csr, SumOp<int>());
+                    segmented_ok = segmented_ok && verify_arrays(parallel_segmented_exclusive_scan(arr, flags, SumOp<int>()), sum_seq) &&
+                                   verify_arrays(parallel_segmented_exclusive_scan(arr, flags, MaxOp<int>()), max_seq);
+                }
+                vector<size_t> size_t_csr(n);
+                if (inclusive) {
+                    parallel_segmented_inclusive_scan<size_t>(arr_size_t, span<const size_t>(offsets), size_t_csr, SumOp<size_t>());
+                } else {
+                    parallel_segmented_exclusive_scan<size_t>(arr_size_t, span<const size_t>(offsets), size_t_csr, SumOp<size_t>());
+                }
+                vector<size_t> size_t_flags = inclusive ? parallel_segmented_inclusive_scan<size_t>(arr_size_t, flags, SumOp<size_t>())
+                                                        : parallel_segmented_exclusive_scan<size_t>(arr_size_t, flags, SumOp<size_t>());
+                segmented_ok = segmented_ok && verify_arrays(sum_csr, sum_seq) &&
+                               size_t_csr == size_t_seq && size_t_flags == size_t_seq;
+            }
+        }
+    }
+    omp_set_num_threads(num_threads);
+    
+    vector<size_t> groups = random_segment_offsets(n, 32, seed);
+    vector<uint8_t> group_flags(n);
+    segment_flags_from_offsets(groups.data(), groups.size() - 1, group_flags.data());
+    start = omp_get_wtime();
+    vector<int> group_sums = parallel_segmented_inclusive_scan(arr, group_flags, SumOp<int>());
+    end = omp_get_wtime();
+    cout << groups.size() - 1 << " segments (mean length 32), sum of the last: " << group_sums[n-1]
+         << ", time: " << (end - start) * 1000 << " ms" << endl;
+    cout << "Verification: " << (segmented_ok ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << endl;
+    
+    // Streaming scan through temporary files, in chunks small enough that
+    // the carry crosses several chunk boundaries
+    cout << "==================================================" << endl;
+    cout << "Streaming Scan (chunked, double-buffered)" << endl;
+    cout << "==================================================" << endl;
+    bool stream_ok = false;
+    FILE* stream_in = tmpfile();
+    FILE* stream_out = tmpfile();
+    if (stream_in && stream_out) {
+        size_t stream_chunk = max<size_t>(n / 5, 1);
+        fwrite(arr.data(), sizeof(int), n, stream_in);
+        rewind(stream_in);
+        
+        StreamScanStats stats;
+        string stream_error;
+        start = omp_get_wtime();
+        stream_ok = parallel_prefix_sum_stream(stream_in, stream_out, stream_chunk, stats, stream_error);
+        end = omp_get_wtime();
+        
+        if (stream_ok) {
+            vector<int> streamed(n);
+            rewind(stream_out);
+            stream_ok = fread(streamed.data(), sizeof(int), n, stream_out) == n && verify_arrays(streamed, result_seq);
+            cout << stats.chunks << " chunks of " << stream_chunk << ", time: " << (end - start) * 1000
+                 << " ms (" << stats.wait_seconds * 1000 << " ms waiting for I/O)" << endl;
+        } else {
+            cout << "Error: " << stream_error << endl;
+        }
+    }
+    if (stream_in) fclose(stream_in);
+    if (stream_out) fclose(stream_out);
+    
+    cout << "Verification: " << (stream_ok ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << endl;
+    
     // Final summary
     cout << "==================================================" << endl;
     cout << "RESUMEN" << endl;
@@ -375,7 +2086,7 @@ int main() {
     cout << "Tamaño del arreglo: " << n << endl;
     cout << "Número de threads: " << num_threads << endl;
     cout << "Suma total: " << result_seq[n-1] << endl;
-    cout << "Todos los métodos: " << (verify_arrays(result1, result_seq) && verify_arrays(result3, result_seq) ? "PASSED ✓" : "FAILED ✗") << endl;
+    cout << "Todos los métodos: " << (verify_arrays(result1, result_seq) && verify_arrays(result3, result_seq) && verify_arrays(result4, result_seq) && verify_arrays(result5, result_seq) && buffers_ok && wide_ok && generic_ok && segmented_ok && stream_ok ? "PASSED ✓" : "FAILED ✗") << endl;
     
     return 0;
 }
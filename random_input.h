@@ -0,0 +1,161 @@
+/**
+ * Parallel, reproducible input generation
+ *
+ * Element i is a pure function of (seed, i): a SplitMix64 hash of a
+ * counter, so threads fill disjoint ranges without sharing generator
+ * state, and the array is identical for any thread count or schedule.
+ *
+ * fill_input() writes with the static partition the methods use
+ * (static_chunk in numa_array.h), so with an allocation that does not
+ * touch its pages (default_init_allocator or NumaArray) every page is
+ * first touched, and placed on the NUMA node of, the thread that will
+ * later read it.
+ *
+ * Distributions (values in [lo, hi]):
+ *   - uniform:     independent uniform values
+ *   - sorted:      non-decreasing ramp from lo (first) to hi (last)
+ *   - reverse:     non-increasing ramp from hi (first) to lo (last)
+ *   - equal:       one seed-dependent value everywhere
+ *   - zipf:        Zipf-like (exponent 1): value lo + k - 1 with
+ *                  P(k) about 1/k, so small values dominate
+ *   - adversarial: an increasing ramp from lo to hi - 1 inside every
+ *                  4096-element block (every comparison updates a
+ *                  running maximum) and the only occurrence of hi at
+ *                  the last index
+ */
+
+#ifndef RANDOM_INPUT_H
+#define RANDOM_INPUT_H
+
+#include <omp.h>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "numa_array.h"
+
+enum class Distribution { Uniform, Sorted, Reverse, Equal, Zipf, Adversarial };
+
+inline const char* distribution_name(Distribution dist) {
+    switch (dist) {
+        case Distribution::Uniform:     return "uniform";
+        case Distribution::Sorted:      return "sorted";
+        case Distribution::Reverse:     return "reverse";
+        case Distribution::Equal:       return "equal";
+        case Distribution::Zipf:        return "zipf";
+        case Distribution::Adversarial: return "adversarial";
+    }
+    return "unknown";
+}
+
+inline bool parse_distribution(const std::string& name, Distribution& dist) {
+    for (Distribution d : {Distribution::Uniform, Distribution::Sorted, Distribution::Reverse,
+                           Distribution::Equal, Distribution::Zipf, Distribution::Adversarial}) {
+        if (name == distribution_name(d)) {
+            dist = d;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * SplitMix64 finalizer: a bijective 64-bit mix with full avalanche
+ */
+inline uint64_t splitmix64(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Random 64-bit value number index of the stream selected by seed
+ */
+inline uint64_t counter_random(uint64_t seed, uint64_t index) {
+    return splitmix64(splitmix64(seed) + (index + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+/**
+ * Maps a random value to [0, range) without a division (range <= 2^32)
+ */
+inline uint64_t bounded_random(uint64_t x, uint64_t range) {
+    return ((x >> 32) * range) >> 32;
+}
+
+/**
+ * Fills data[0..n) in parallel with values in [lo, hi] drawn from dist
+ */
+inline void fill_input(int* data, size_t n, Distribution dist, uint64_t seed, int lo, int hi) {
+    const size_t BLOCK = 4096;  // Ramp length of the adversarial pattern
+    uint64_t range = (uint64_t)((int64_t)hi - lo) + 1;
+    int constant = lo + (int)bounded_random(counter_random(seed, 0), range);
+    double log_range = std::log((double)range + 1.0);
+
+    #pragma omp parallel
+    {
+        size_t start, end;
+        static_chunk(n, omp_get_thread_num(), omp_get_num_threads(), start, end);
+        for (size_t i = start; i < end; i++) {
+            uint64_t offset = 0;
+            switch (dist) {
+                case Distribution::Uniform:
+                    offset = bounded_random(counter_random(seed, i), range);
+                    break;
+                case Distribution::Sorted:
+                case Distribution::Reverse:
+                    // Exact integer scaling, so index n-1 lands on hi
+                    offset = (n > 1) ? (uint64_t)((unsigned __int128)i * (range - 1) / (n - 1)) : 0;
+                    if (dist == Distribution::Reverse) offset = range - 1 - offset;
+                    break;
+                case Distribution::Equal:
+                    data[i] = constant;
+                    continue;
+                case Distribution::Zipf: {
+                    // Inverse CDF of the continuous 1/k density on [1, range + 1)
+                    double u = (counter_random(seed, i) >> 11) * 0x1.0p-53;
+                    offset = (uint64_t)std::exp(u * log_range) - 1;
+                    if (offset >= range) offset = range - 1;
+                    break;
+                }
+                case Distribution::Adversarial:
+                    offset = (i == n - 1 || range < 2) ? range - 1 : (range - 2) * (i % BLOCK) / (BLOCK - 1);
+                    break;
+            }
+            data[i] = (int)((int64_t)lo + (int64_t)offset);
+        }
+    }
+}
+
+/**
+ * Allocator that default-initializes instead of value-initializing, so
+ * vector<T, default_init_allocator<T>>(n) leaves the memory untouched
+ * for a parallel first-touch fill instead of zeroing it on one thread
+ */
+template <typename T, typename A = std::allocator<T>>
+class default_init_allocator : public A {
+    using traits = std::allocator_traits<A>;
+
+public:
+    template <typename U>
+    struct rebind {
+        using other = default_init_allocator<U, typename traits::template rebind_alloc<U>>;
+    };
+
+    using A::A;
+
+    template <typename U>
+    void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new (static_cast<void*>(ptr)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) {
+        traits::construct(static_cast<A&>(*this), ptr, std::forward<Args>(args)...);
+    }
+};
+
+#endif // RANDOM_INPUT_H
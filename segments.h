@@ -0,0 +1,111 @@
+/**
+ * Segment descriptions for the segmented reductions (parallel_maximum.cpp)
+ * and segmented scans (prefix_sum_scan.cpp)
+ *
+ * Many short variable-length groups packed into one array of n elements
+ * are described in one of two ways:
+ *   - head flags:  flags[i] != 0 marks the first element of a segment.
+ *                  Position 0 always starts a segment, whatever flags[0]
+ *                  says. Segments are never empty.
+ *   - CSR offsets: segment s is [offsets[s], offsets[s+1]) for
+ *                  s < num_segments, with offsets[0] = 0, non-decreasing
+ *                  offsets and offsets[num_segments] = n. Empty segments
+ *                  are allowed.
+ *
+ * The reductions work on offsets and the scans on flags; the conversions
+ * below let each accept the other form at the cost of one extra parallel
+ * pass. Both split the work by element count with static_chunk, so one
+ * huge segment and millions of tiny ones balance the same way.
+ */
+
+#ifndef SEGMENTS_H
+#define SEGMENTS_H
+
+#include <omp.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "numa_array.h"
+#include "random_input.h"
+
+/**
+ * CSR offsets of the segments started by the head flags (num_segments + 1
+ * entries). Each thread counts the heads of its chunk, the counts are
+ * scanned serially, then every thread writes its heads' positions.
+ */
+inline std::vector<size_t> segment_offsets_from_flags(const uint8_t* flags, size_t n) {
+    if (n == 0) return std::vector<size_t>(1, 0);
+
+    int num_threads = omp_get_max_threads();
+    std::vector<size_t> first_segment(num_threads + 1, 0);
+    std::vector<size_t> offsets;
+
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int tid = omp_get_thread_num();
+        size_t start, end;
+        static_chunk(n, tid, num_threads, start, end);
+
+        size_t heads = 0;
+        for (size_t i = start; i < end; i++) {
+            heads += (flags[i] != 0 || i == 0);
+        }
+        first_segment[tid + 1] = heads;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (int t = 0; t < num_threads; t++) first_segment[t + 1] += first_segment[t];
+            offsets.resize(first_segment[num_threads] + 1);
+            offsets[first_segment[num_threads]] = n;
+        }
+
+        size_t s = first_segment[tid];
+        for (size_t i = start; i < end; i++) {
+            if (flags[i] != 0 || i == 0) offsets[s++] = i;
+        }
+    }
+    return offsets;
+}
+
+/**
+ * Head flags (n entries) of the non-empty CSR segments; empty segments
+ * leave no trace, as in the flag form
+ */
+inline void segment_flags_from_offsets(const size_t* offsets, size_t num_segments, uint8_t* flags) {
+    size_t n = offsets[num_segments];
+
+    #pragma omp parallel
+    {
+        size_t start, end;
+        static_chunk(n, omp_get_thread_num(), omp_get_num_threads(), start, end);
+        std::fill(flags + start, flags + end, uint8_t(0));
+
+        #pragma omp barrier
+
+        // Non-empty segments start at distinct positions, so no two
+        // threads write the same flag
+        #pragma omp for schedule(static)
+        for (size_t s = 0; s < num_segments; s++) {
+            if (offsets[s] < offsets[s + 1]) flags[offsets[s]] = 1;
+        }
+    }
+}
+
+/**
+ * Reproducible CSR offsets over n elements with segment lengths uniform
+ * in [0, 2 * mean_length] (capped at 2^32), so empty segments occur (the
+ * last segment takes the remainder)
+ */
+inline std::vector<size_t> random_segment_offsets(size_t n, size_t mean_length, uint64_t seed) {
+    std::vector<size_t> offsets(1, 0);
+    uint64_t range = std::min<uint64_t>(2 * std::max<size_t>(mean_length, 1) + 1, uint64_t(1) << 32);
+    for (size_t s = 0; offsets.back() < n; s++) {
+        size_t length = bounded_random(counter_random(seed, s), range);
+        offsets.push_back(std::min(offsets.back() + length, n));
+    }
+    return offsets;
+}
+
+#endif // SEGMENTS_H
@@ -0,0 +1,167 @@
+/**
+ * Per-phase tracing in Chrome trace format
+ *
+ * TRACE_SCOPE("phase") / TRACE_SCOPE_ARG("phase", level) record the
+ * begin/end timestamps of the enclosing block on the calling thread.
+ * Each thread appends to its own preallocated buffer, so recording
+ * takes no locks; the only lock is taken once per thread, when its
+ * buffer is registered. trace_write_chrome_json() dumps all buffers as
+ * a JSON file that chrome://tracing or Perfetto can open.
+ * TRACE_PAUSE() / TRACE_RESUME() skip recording between parallel regions
+ * (e.g. during warm-up runs).
+ *
+ * Tracing is compiled out entirely unless ENABLE_TRACE is defined:
+ *     g++ -DENABLE_TRACE ...
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef ENABLE_TRACE
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+    const char* name;  // Must be a string literal
+    int arg;           // Level or other phase argument, -1 if none
+    int64_t begin_ns;
+    int64_t end_ns;
+};
+
+struct TraceBuffer {
+    static const size_t CAPACITY = 1 << 18;  // Events kept per thread
+
+    int thread_index;
+    size_t dropped = 0;
+    std::vector<TraceEvent> events;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+inline TraceRegistry& trace_registry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+// Runtime switch, only flipped between parallel regions
+inline bool trace_active = true;
+
+inline int64_t trace_now_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * The calling thread's buffer, registered on first use
+ */
+inline TraceBuffer& trace_thread_buffer() {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        TraceRegistry& registry = trace_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.buffers.push_back(std::make_unique<TraceBuffer>());
+        buffer = registry.buffers.back().get();
+        buffer->thread_index = (int)registry.buffers.size() - 1;
+        buffer->events.reserve(TraceBuffer::CAPACITY);
+    }
+    return *buffer;
+}
+
+inline void trace_record(const char* name, int arg, int64_t begin_ns, int64_t end_ns) {
+    if (!trace_active) return;
+    TraceBuffer& buffer = trace_thread_buffer();
+    if (buffer.events.size() < TraceBuffer::CAPACITY) {
+        buffer.events.push_back({name, arg, begin_ns, end_ns});
+    } else {
+        buffer.dropped++;
+    }
+}
+
+class TraceScope {
+public:
+    TraceScope(const char* name, int arg) : name_(name), arg_(arg), begin_ns_(trace_now_ns()) {}
+    ~TraceScope() { trace_record(name_, arg_, begin_ns_, trace_now_ns()); }
+
+private:
+    const char* name_;
+    int arg_;
+    int64_t begin_ns_;
+};
+
+/**
+ * Discards recorded events (call only while no parallel region runs)
+ */
+inline void trace_clear() {
+    TraceRegistry& registry = trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& buffer : registry.buffers) {
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+}
+
+/**
+ * Writes every recorded event as a Chrome "complete" (ph = X) event.
+ * Returns false if the file cannot be written.
+ */
+inline bool trace_write_chrome_json(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    TraceRegistry& registry = trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    int64_t origin = INT64_MAX;
+    for (auto& buffer : registry.buffers) {
+        for (const TraceEvent& e : buffer->events) origin = std::min(origin, e.begin_ns);
+    }
+
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    for (auto& buffer : registry.buffers) {
+        for (const TraceEvent& e : buffer->events) {
+            out << (first ? "" : ",\n")
+                << "{\"name\": \"" << e.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->thread_index
+                << ", \"ts\": " << (e.begin_ns - origin) / 1000.0 << ", \"dur\": " << (e.end_ns - e.begin_ns) / 1000.0;
+            if (e.arg >= 0) out << ", \"args\": {\"level\": " << e.arg << "}";
+            out << "}";
+            first = false;
+        }
+        if (buffer->dropped > 0) {
+            out << (first ? "" : ",\n")
+                << "{\"name\": \"dropped events\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": "
+                << buffer->thread_index << ", \"ts\": 0, \"args\": {\"count\": " << buffer->dropped << "}}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return true;
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, -1)
+#define TRACE_SCOPE_ARG(name, arg) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, (int)(arg))
+#define TRACE_PAUSE() (trace_active = false)
+#define TRACE_RESUME() (trace_active = true)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, arg) ((void)0)
+#define TRACE_PAUSE() ((void)0)
+#define TRACE_RESUME() ((void)0)
+
+#endif // ENABLE_TRACE
+
+#endif // TRACE_H
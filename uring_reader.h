@@ -0,0 +1,477 @@
+/**
+ * Asynchronous multi-file reader on io_uring (raw syscalls, no liburing)
+ *
+ * read_shards() streams every file of a shard list through a fixed pool
+ * of aligned buffers, keeping up to queue_depth reads in flight across
+ * files. Each completed buffer is handed to a consumer callback on the
+ * calling thread, then immediately reused for the next read, so the
+ * device keeps working on the other queue_depth - 1 reads while the
+ * consumer runs. Files are opened lazily and closed once their last
+ * block is consumed, so at most queue_depth + 1 descriptors are open.
+ *
+ * Options:
+ *   - direct:           O_DIRECT, bypass the page cache (falls back to a
+ *                       buffered open on filesystems without it, e.g. tmpfs)
+ *   - register_buffers: IORING_REGISTER_BUFFERS + READ_FIXED, pins the
+ *                       buffers once instead of on every read (falls back
+ *                       when RLIMIT_MEMLOCK is too small)
+ *   - use_uring:        false, or a kernel without io_uring, uses
+ *                       synchronous pread with the same driver
+ */
+
+#ifndef URING_READER_H
+#define URING_READER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHARD_READER_POSIX 1
+#else
+#define SHARD_READER_POSIX 0
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define SHARD_READER_URING 1
+#else
+#define SHARD_READER_URING 0
+#endif
+
+// Buffer, offset and length alignment: the page size, and a multiple of
+// the logical block size O_DIRECT requires
+const size_t SHARD_ALIGNMENT = 4096;
+
+struct ShardReadOptions {
+    size_t block_size = 1 << 20;    // Bytes per read, rounded up to 4 KB
+    unsigned queue_depth = 32;      // Reads in flight (and buffers allocated)
+    bool direct = false;
+    bool register_buffers = false;
+    bool use_uring = true;
+};
+
+struct ShardReadStats {
+    size_t files = 0;
+    size_t bytes = 0;
+    size_t reads = 0;             // Reads submitted, including retries of short reads
+    bool used_uring = false;
+    bool registered = false;      // Buffers were registered with the ring
+    size_t direct_files = 0;      // Files actually opened with O_DIRECT
+};
+
+/**
+ * One completed block: bytes of file `shard` starting at `offset`.
+ * The data is only valid during the consumer call.
+ */
+struct ShardBlock {
+    size_t shard;
+    uint64_t offset;
+    const char* data;
+    size_t bytes;
+    uint64_t file_size;  // Size of the whole shard, taken when it was opened
+};
+
+// Returns false (after setting its own error) to stop the whole read
+using ShardConsumer = std::function<bool(const ShardBlock&)>;
+
+#if SHARD_READER_POSIX
+
+struct ShardCompletion {
+    uint64_t slot;
+    int result;  // Bytes read, or -errno
+};
+
+/**
+ * Synchronous backend: every read completes at submission
+ */
+class PreadBackend {
+public:
+    void queue_read(int fd, char* buffer, size_t length, uint64_t offset, uint64_t slot, int) {
+        ssize_t result = pread(fd, buffer, length, offset);
+        done_.push_back({slot, result < 0 ? -errno : (int)result});
+    }
+
+    bool wait(std::vector<ShardCompletion>& completions, std::string&) {
+        completions.assign(done_.begin(), done_.end());
+        done_.clear();
+        return true;
+    }
+
+private:
+    std::deque<ShardCompletion> done_;
+};
+
+#if SHARD_READER_URING
+
+/**
+ * Minimal io_uring: one submission queue and one completion queue mapped
+ * from the ring fd, filled and drained by a single thread
+ */
+class UringBackend {
+public:
+    UringBackend() = default;
+    UringBackend(const UringBackend&) = delete;
+    UringBackend& operator=(const UringBackend&) = delete;
+    ~UringBackend() { close(); }
+
+    bool setup(unsigned entries, std::string& error) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ring_fd_ = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (ring_fd_ < 0) {
+            error = std::string("io_uring_setup failed: ") + std::strerror(errno);
+            return false;
+        }
+
+        sq_length_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_length_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) sq_length_ = cq_length_ = std::max(sq_length_, cq_length_);
+
+        sq_ptr_ = mmap(nullptr, sq_length_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+        cq_ptr_ = single_mmap ? sq_ptr_
+                              : mmap(nullptr, cq_length_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+        sqes_length_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, sqes_length_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+        if (sq_ptr_ == MAP_FAILED || cq_ptr_ == MAP_FAILED || sqes == MAP_FAILED) {
+            error = std::string("cannot map the io_uring queues: ") + std::strerror(errno);
+            if (sqes != MAP_FAILED) munmap(sqes, sqes_length_);
+            if (sq_ptr_ == MAP_FAILED) sq_ptr_ = nullptr;
+            if (cq_ptr_ == MAP_FAILED) cq_ptr_ = nullptr;
+            close();
+            return false;
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(sq_ptr_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ptr_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    /**
+     * Pins the buffers so READ_FIXED skips the per-read page pinning.
+     * Returns false (and the ring keeps working) if the kernel refuses.
+     */
+    bool register_buffers(const std::vector<iovec>& buffers) {
+        fixed_ = syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS, buffers.data(), (unsigned)buffers.size()) == 0;
+        return fixed_;
+    }
+
+    void queue_read(int fd, char* buffer, size_t length, uint64_t offset, uint64_t slot, int buffer_index) {
+        // Only this thread writes the SQ tail, so a plain read of it is enough
+        unsigned tail = *sq_tail_;
+        unsigned index = tail & sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = fixed_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer);
+        sqe->len = (unsigned)length;
+        sqe->off = offset;
+        sqe->user_data = slot;
+        if (fixed_) sqe->buf_index = (uint16_t)buffer_index;
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        pending_++;
+    }
+
+    /**
+     * Submits the queued reads and waits for at least one completion,
+     * then drains every completion already posted
+     */
+    bool wait(std::vector<ShardCompletion>& completions, std::string& error) {
+        completions.clear();
+        for (;;) {
+            int submitted = (int)syscall(__NR_io_uring_enter, ring_fd_, pending_, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (submitted < 0) {
+                if (errno == EINTR) continue;
+                error = std::string("io_uring_enter failed: ") + std::strerror(errno);
+                return false;
+            }
+            pending_ -= std::min(pending_, (unsigned)submitted);
+
+            unsigned head = *cq_head_;
+            unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+                completions.push_back({cqe.user_data, cqe.res});
+            }
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+            if (!completions.empty()) return true;
+        }
+    }
+
+    void close() {
+        if (sqes_) munmap(sqes_, sqes_length_);
+        if (cq_ptr_ && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_length_);
+        if (sq_ptr_) munmap(sq_ptr_, sq_length_);
+        if (ring_fd_ >= 0) ::close(ring_fd_);
+        sqes_ = nullptr;
+        cq_ptr_ = sq_ptr_ = nullptr;
+        ring_fd_ = -1;
+    }
+
+private:
+    int ring_fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    size_t sq_length_ = 0;
+    size_t cq_length_ = 0;
+    size_t sqes_length_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned pending_ = 0;  // Queued but not yet submitted
+    bool fixed_ = false;
+};
+
+#endif // SHARD_READER_URING
+
+/**
+ * Drives one backend: hands out buffers to the next blocks in shard
+ * order, retries short reads, and passes completed blocks to consume.
+ * Returns only once no read is in flight; drained is false if the
+ * backend kept failing and reads may still target the buffers, which
+ * must then never be freed.
+ */
+template <typename Backend>
+bool read_shards_with(Backend& backend, const std::vector<std::string>& paths, const ShardReadOptions& options,
+                      std::vector<char*>& buffers, size_t block_size, const ShardConsumer& consume,
+                      ShardReadStats& stats, std::string& error, bool& drained) {
+    struct Shard {
+        int fd = -1;
+        uint64_t size = 0;
+        size_t in_flight = 0;  // Blocks submitted and not yet consumed
+        bool issued = false;   // Every block has been submitted
+        bool direct = false;   // Opened with O_DIRECT
+    };
+    struct Slot {
+        size_t shard;
+        uint64_t offset;
+        size_t expected;  // Bytes the block should contain
+        size_t done;      // Bytes already read (short reads are retried)
+        size_t from;      // Start of the read in flight within the block
+        unsigned stalls;  // Retries in a row that read nothing new
+    };
+
+    std::vector<Shard> shards(paths.size());
+    std::vector<Slot> slots(buffers.size());
+    std::vector<size_t> free_slots;
+    for (size_t i = buffers.size(); i > 0; i--) free_slots.push_back(i - 1);
+
+    const unsigned MAX_STALLS = 8;
+    size_t next_shard = 0;
+    uint64_t next_offset = 0;
+    size_t in_flight = 0;
+    bool ok = true;
+
+    auto close_shard = [&](size_t s) {
+        if (shards[s].fd >= 0) ::close(shards[s].fd);
+        shards[s].fd = -1;
+    };
+    auto submit = [&](size_t slot) {
+        Slot& b = slots[slot];
+        const Shard& shard = shards[b.shard];
+        // O_DIRECT needs the buffer, the offset and the length aligned:
+        // a read, or the retry of a short one, starts at the last aligned
+        // byte already read and asks for the rest of the buffer, letting
+        // the read stop at end of file
+        b.from = shard.direct ? b.done / SHARD_ALIGNMENT * SHARD_ALIGNMENT : b.done;
+        size_t length = shard.direct ? block_size - b.from : b.expected - b.done;
+        backend.queue_read(shard.fd, buffers[slot] + b.from, length, b.offset + b.from, slot, (int)slot);
+        stats.reads++;
+        in_flight++;
+    };
+
+    // Opens shards in order until one has a block left, then submits it
+    auto fill = [&](size_t slot) {
+        while (next_shard < paths.size()) {
+            Shard& shard = shards[next_shard];
+            if (shard.fd < 0 && !shard.issued) {
+                int flags = O_RDONLY;
+#ifdef O_DIRECT
+                if (options.direct) flags |= O_DIRECT;
+#endif
+                shard.fd = ::open(paths[next_shard].c_str(), flags);
+                if (shard.fd < 0 && flags != O_RDONLY && errno == EINVAL) {
+                    shard.fd = ::open(paths[next_shard].c_str(), O_RDONLY);
+                } else if (shard.fd >= 0 && flags != O_RDONLY) {
+                    shard.direct = true;
+                    stats.direct_files++;
+                }
+                struct stat st;
+                if (shard.fd < 0 || fstat(shard.fd, &st) != 0) {
+                    error = "cannot open " + paths[next_shard] + ": " + std::strerror(errno);
+                    return false;
+                }
+                shard.size = st.st_size;
+                stats.files++;
+            }
+            if (next_offset < shard.size) {
+                size_t expected = (size_t)std::min<uint64_t>(block_size, shard.size - next_offset);
+                slots[slot] = {next_shard, next_offset, expected, 0, 0, 0};
+                shard.in_flight++;
+                next_offset += expected;
+                shard.issued = (next_offset >= shard.size);
+                submit(slot);
+                return true;
+            }
+            shard.issued = true;
+            if (shard.in_flight == 0) close_shard(next_shard);
+            next_shard++;
+            next_offset = 0;
+        }
+        free_slots.push_back(slot);
+        return true;
+    };
+
+    while (ok && !free_slots.empty() && next_shard < paths.size()) {
+        size_t slot = free_slots.back();
+        free_slots.pop_back();
+        ok = fill(slot);
+    }
+
+    // After an error the remaining reads are still drained, since the
+    // kernel may write into their buffers until they complete. A failed
+    // wait leaves them in flight too, so it is retried with a short pause
+    const int MAX_FAILED_WAITS = 1000;
+    std::vector<ShardCompletion> completions;
+    int failed_waits = 0;
+    drained = true;
+    while (in_flight > 0) {
+        std::string wait_error;
+        if (!backend.wait(completions, wait_error)) {
+            if (ok) error = wait_error;
+            ok = false;
+            if (++failed_waits == MAX_FAILED_WAITS) {
+                drained = false;
+                break;
+            }
+            usleep(1000);
+            continue;
+        }
+        failed_waits = 0;
+        for (const ShardCompletion& c : completions) {
+            in_flight--;
+            if (!ok) continue;  // Drain the rest without consuming
+            Slot& b = slots[c.slot];
+            if (c.result == -EINTR || c.result == -EAGAIN) {
+                submit(c.slot);
+                continue;
+            }
+            if (c.result < 0) {
+                error = "read of " + paths[b.shard] + " failed: " + std::strerror(-c.result);
+                ok = false;
+                continue;
+            }
+            // An aligned retry re-reads up to one alignment unit, so a
+            // short read may add nothing new; give up after a few of those
+            size_t before = b.done;
+            b.done = std::max(b.done, std::min(b.from + (size_t)c.result, b.expected));
+            b.stalls = (b.done > before) ? 0 : b.stalls + 1;
+            if (c.result > 0 && b.done < b.expected && b.stalls < MAX_STALLS) {
+                submit(c.slot);
+                continue;
+            }
+            if (b.done < b.expected) {
+                error = paths[b.shard] + " shrank while it was read";
+                ok = false;
+                continue;
+            }
+
+            stats.bytes += b.done;
+            ok = consume({b.shard, b.offset, buffers[c.slot], b.done, shards[b.shard].size});
+            Shard& shard = shards[b.shard];
+            shard.in_flight--;
+            if (shard.issued && shard.in_flight == 0) close_shard(b.shard);
+            if (ok) ok = fill(c.slot);
+        }
+    }
+
+    for (size_t s = 0; s < shards.size(); s++) close_shard(s);
+    return ok;
+}
+
+#endif // SHARD_READER_POSIX
+
+/**
+ * Reads every file in paths and calls consume once per block.
+ * Blocks of one file arrive in any order. Returns false with error set
+ * if a file cannot be read or the consumer stops the read.
+ */
+inline bool read_shards(const std::vector<std::string>& paths, const ShardReadOptions& options,
+                        const ShardConsumer& consume, ShardReadStats& stats, std::string& error) {
+    stats = ShardReadStats();
+#if SHARD_READER_POSIX
+    size_t block_size = (std::max<size_t>(options.block_size, 1) + SHARD_ALIGNMENT - 1) / SHARD_ALIGNMENT * SHARD_ALIGNMENT;
+    unsigned depth = std::max(options.queue_depth, 1u);
+
+    std::vector<char*> buffers(depth);
+    for (char*& buffer : buffers) buffer = static_cast<char*>(std::aligned_alloc(SHARD_ALIGNMENT, block_size));
+    bool allocated = std::all_of(buffers.begin(), buffers.end(), [](char* b) { return b != nullptr; });
+
+    bool ok = false;
+    bool drained = true;
+    if (!allocated) {
+        error = "cannot allocate the read buffers";
+    } else {
+#if SHARD_READER_URING
+        UringBackend ring;
+        std::string setup_error;
+        if (options.use_uring && ring.setup(depth, setup_error)) {
+            stats.used_uring = true;
+            if (options.register_buffers) {
+                std::vector<iovec> iovecs(depth);
+                for (unsigned i = 0; i < depth; i++) iovecs[i] = {buffers[i], block_size};
+                stats.registered = ring.register_buffers(iovecs);
+            }
+            ok = read_shards_with(ring, paths, options, buffers, block_size, consume, stats, error, drained);
+        }
+#endif
+        if (!stats.used_uring) {
+            PreadBackend backend;
+            ok = read_shards_with(backend, paths, options, buffers, block_size, consume, stats, error, drained);
+        }
+    }
+    // Buffers with reads possibly still in flight are leaked, not freed
+    if (drained) {
+        for (char* buffer : buffers) std::free(buffer);
+    } else {
+        error += " (reads still in flight, buffers not released)";
+    }
+    return ok;
+#else
+    (void)paths;
+    (void)options;
+    (void)consume;
+    error = "shard reading needs a POSIX system";
+    return false;
+#endif
+}
+
+#endif // URING_READER_H